@@ -1,6 +1,9 @@
 #include "BLEAbstractController.h"
 
 #include <NimBLEDevice.h>
+#include <esp_timer.h>
+#include <cinttypes>
+#include "BLEDispatcher.h"
 #include "BLEGamepadClient.h"
 #include "logger.h"
 #include "utils.h"
@@ -10,7 +13,42 @@ BLEAbstractController::BLEAbstractController()
       _address(0),
       _pClient(nullptr),
       _connectionState(ConnectionState::Disconnected),
-      _lastAddress(NimBLEAddress()) {}
+      _storedAddress(0),
+      _cacheLoaded(false),
+      _connectionProfile(BLEConnectionProfile::Default),
+      _idleTimer(nullptr),
+      _lastActivityUs(0),
+      _idle(false),
+      _switchPending(false),
+      _modeRequestPending(false),
+      _requestedIdle(false),
+      _timingsMutex(xSemaphoreCreateMutex()),
+      _timings(),
+      _timingsHistory(),
+      _timingsHistoryHead(0),
+      _timingsHistoryCount(0),
+      _modeSinceUs(0),
+      _activeModeUs(0),
+      _idleModeUs(0),
+      _modeSwitches(0) {
+  configASSERT(_timingsMutex);
+
+  // checking a few times per timeout bounds the delay of switching to the idle parameters
+  _idleTimer = xTimerCreate("_idleTimer", pdMS_TO_TICKS(CONFIG_BT_BLEGC_ADAPTIVE_IDLE_TIMEOUT_MS / 4), pdTRUE, this,
+                            _idleTimerFn);
+  configASSERT(_idleTimer);
+}
+
+BLEAbstractController::~BLEAbstractController() {
+  if (_idleTimer != nullptr) {
+    xTimerDelete(_idleTimer, portMAX_DELAY);
+    _idleTimer = nullptr;
+  }
+  if (_timingsMutex != nullptr) {
+    vSemaphoreDelete(_timingsMutex);
+    _timingsMutex = nullptr;
+  }
+}
 
 void BLEAbstractController::begin() {
   BLEGamepadClient::init();
@@ -70,7 +108,6 @@ bool BLEAbstractController::tryDeallocate() {
     }
   } while (!_address.compare_exchange_weak(addressOld, 0));
 
-  _lastAddress = _decodeAddress(addressOld);
   return true;
 }
 
@@ -86,7 +123,9 @@ bool BLEAbstractController::isConnecting() const {
 }
 
 NimBLEAddress BLEAbstractController::getLastAddress() const {
-  return _lastAddress;
+  NimBLEAddress address;
+  _lastAddress.read(&address);
+  return address;
 }
 
 bool BLEAbstractController::isAllocated() const {
@@ -101,11 +140,18 @@ void BLEAbstractController::markConnecting() {
 }
 
 void BLEAbstractController::markConnected() {
+  markStage(BLEConnectionStage::MarkedConnected, esp_timer_get_time());
   _connectionState = ConnectionState::Connected;
 }
 
 void BLEAbstractController::markDisconnected() {
   _connectionState = ConnectionState::Disconnected;
+
+  xTimerStop(_idleTimer, portMAX_DELAY);
+  configASSERT(xSemaphoreTake(_timingsMutex, portMAX_DELAY));
+  _accountModeTime(esp_timer_get_time());
+  _modeSinceUs = 0;
+  configASSERT(xSemaphoreGive(_timingsMutex));
 }
 
 bool BLEAbstractController::isPendingDeregistration() const {
@@ -113,20 +159,159 @@ bool BLEAbstractController::isPendingDeregistration() const {
 }
 
 bool BLEAbstractController::hidInit() {
-  _readDeviceInfo();
+  const auto startUs = esp_timer_get_time();
+
+  _cacheLoaded = _loadCache();
+  if (!_cacheLoaded) {
+    _deviceInfo = BLEDeviceInfo();
+    const auto deviceInfoRead = _readDeviceInfo();
+
+    _reportMap.clear();
+    const auto reportMapRead = blegc::readReportMap(_pClient, &_reportMap);
+
+    // attributes that failed to be read are read again on the next connection, instead of being cached incomplete
+    if (deviceInfoRead && reportMapRead && !_reportMap.empty()) {
+      _storeCache();
+    }
+  }
+
   BLEGC_LOGD("%s", std::string(_deviceInfo).c_str());
+  BLEGC_LOGD_BUFFER_HEX(_reportMap.data(), _reportMap.size());
+  const auto endUs = esp_timer_get_time();
+  BLEGC_LOGD("HID attributes %s in %" PRId64 " us", _cacheLoaded ? "loaded from cache" : "read", endUs - startUs);
+  markStage(BLEConnectionStage::HidInitDone, endUs);
+  return true;
+}
+
+/**
+ * @brief Removes the cached attributes of the connected controller, so that they are read again on the next
+ * initialization. Called when initializing with cached attributes fails, as they may be stale.
+ */
+void BLEAbstractController::invalidateCache() {
+  auto* pStorage = BLEGamepadClient::getStorage();
+  if (!pStorage || !_cacheLoaded) {
+    return;
+  }
+
+  BLEGC_LOGD("Invalidating cached attributes, address: %s", std::string(getAddress()).c_str());
+  pStorage->remove(_cacheKey().c_str());
+  _cacheLoaded = false;
+}
+
+// Cache layout: version, then manufacturer name, model name, serial number, firmware revision and PnP ID, each
+// prefixed with a 1-byte length, then the report map prefixed with a 2-byte little-endian length.
+constexpr uint8_t cacheVersion = 1;
+
+static void putField(std::vector<uint8_t>& out, const uint8_t* data, const size_t len) {
+  const auto fieldLen = len < UINT8_MAX ? len : UINT8_MAX;
+  out.push_back(fieldLen);
+  out.insert(out.end(), data, data + fieldLen);
+}
+
+static bool getField(const std::vector<uint8_t>& in, size_t& pos, const size_t lenBytes, const uint8_t** pData,
+                     size_t* pLen) {
+  if (pos + lenBytes > in.size()) {
+    return false;
+  }
 
-  std::vector<uint8_t> buffer;
-  blegc::readReportMap(_pClient, &buffer);
-  BLEGC_LOGD_BUFFER_HEX(buffer.data(), buffer.size());
+  size_t len = in[pos];
+  if (lenBytes == 2) {
+    len |= in[pos + 1] << 8;
+  }
+  pos += lenBytes;
+  if (pos + len > in.size()) {
+    return false;
+  }
+
+  *pData = in.data() + pos;
+  *pLen = len;
+  pos += len;
   return true;
 }
 
-void BLEAbstractController::_readDeviceInfo() {
+std::string BLEAbstractController::_cacheKey() const {
+  // NVS keys are limited to 15 characters
+  char key[16];
+  const auto address = _encodeAddress(getAddress());
+  snprintf(key, sizeof(key), "h%014llx", static_cast<unsigned long long>(address) & 0xffffffffffffffull);
+  return key;
+}
+
+bool BLEAbstractController::_loadCache() {
+  auto* pStorage = BLEGamepadClient::getStorage();
+  if (!pStorage) {
+    return false;
+  }
+
+  const auto key = _cacheKey();
+  std::vector<uint8_t> data(pStorage->length(key.c_str()));
+  if (data.empty() || pStorage->read(key.c_str(), data.data(), data.size()) != data.size() ||
+      data[0] != cacheVersion) {
+    return false;
+  }
+
+  // a cache entry that fails to parse leaves the attributes untouched
+  BLEDeviceInfo deviceInfo;
+  std::vector<uint8_t> reportMap;
+  std::string* strings[] = {&deviceInfo.manufacturerName, &deviceInfo.modelName, &deviceInfo.serialNumber,
+                            &deviceInfo.firmwareRevision};
+  size_t pos = 1;
+  const uint8_t* pField;
+  size_t fieldLen;
+  for (auto* pString : strings) {
+    if (!getField(data, pos, 1, &pField, &fieldLen)) {
+      return false;
+    }
+    pString->assign(reinterpret_cast<const char*>(pField), fieldLen);
+  }
+
+  if (!getField(data, pos, 1, &pField, &fieldLen)) {
+    return false;
+  }
+  deviceInfo.pnpId.assign(pField, pField + fieldLen);
+
+  if (!getField(data, pos, 2, &pField, &fieldLen)) {
+    return false;
+  }
+  reportMap.assign(pField, pField + fieldLen);
+
+  _deviceInfo = std::move(deviceInfo);
+  _reportMap = std::move(reportMap);
+  return true;
+}
+
+void BLEAbstractController::_storeCache() {
+  auto* pStorage = BLEGamepadClient::getStorage();
+  if (!pStorage) {
+    return;
+  }
+
+  if (_reportMap.size() > UINT16_MAX) {
+    BLEGC_LOGW("Report map too long to be cached, length: %zu", _reportMap.size());
+    return;
+  }
+
+  std::vector<uint8_t> data;
+  data.push_back(cacheVersion);
+  for (const auto* pString : {&_deviceInfo.manufacturerName, &_deviceInfo.modelName, &_deviceInfo.serialNumber,
+                              &_deviceInfo.firmwareRevision}) {
+    putField(data, reinterpret_cast<const uint8_t*>(pString->data()), pString->size());
+  }
+  putField(data, _deviceInfo.pnpId.data(), _deviceInfo.pnpId.size());
+  data.push_back(_reportMap.size() & 0xff);
+  data.push_back(_reportMap.size() >> 8);
+  data.insert(data.end(), _reportMap.begin(), _reportMap.end());
+
+  if (!pStorage->write(_cacheKey().c_str(), data.data(), data.size())) {
+    BLEGC_LOGW("Failed to cache attributes, address: %s", std::string(getAddress()).c_str());
+  }
+}
+
+bool BLEAbstractController::_readDeviceInfo() {
   auto* pService = _pClient->getService(blegc::deviceInfoSvcUUID);
   if (!pService) {
     BLEGC_LOGE("Service not found, service uuid: %s", std::string(NimBLEUUID(blegc::deviceInfoSvcUUID)).c_str());
-    return;
+    return false;
   }
 
   auto characteristics = pService->getCharacteristics(false);
@@ -137,6 +322,7 @@ void BLEAbstractController::_readDeviceInfo() {
   for (auto* pChar : characteristics) {
     if (!pChar->canRead()) {
       BLEGC_LOGD("Skipping non-readable characteristic, uuid: %s", std::string(pChar->getUUID()).c_str());
+      continue;
     }
 
     const auto attValue = pChar->readValue();
@@ -152,6 +338,266 @@ void BLEAbstractController::_readDeviceInfo() {
       _deviceInfo.pnpId.assign(attValue.begin(), attValue.end());
     }
   }
+  return true;
+}
+
+/**
+ * @brief Sets the connection parameters requested from the controller after it connects. A profile set while the
+ * controller is connected is applied on the next connection.
+ * @param profile Connection profile.
+ */
+void BLEAbstractController::setConnectionProfile(const BLEConnectionProfile profile) {
+  _connectionProfile = profile;
+}
+
+BLEConnectionProfile BLEAbstractController::getConnectionProfile() const {
+  return _connectionProfile;
+}
+
+/**
+ * @brief Returns the parameters of the current connection, as negotiated with the controller. If the controller is
+ * not connected, all parameters are 0.
+ * @return Connection parameters.
+ */
+BLEConnectionParams BLEAbstractController::getConnectionParams() const {
+  BLEConnectionParams params;
+  auto* pClient = getClient();
+  if (!isConnected() || !pClient) {
+    return params;
+  }
+
+  const auto connInfo = pClient->getConnInfo();
+  params.intervalUs = connInfo.getConnInterval() * 1250;  // in 1.25 ms units
+  params.latency = connInfo.getConnLatency();
+  params.supervisionTimeoutMs = connInfo.getConnTimeout() * 10;  // in 10 ms units
+  return params;
+}
+
+struct RequestedConnParams {
+  uint16_t minInterval;
+  uint16_t maxInterval;
+  uint16_t latency;
+  uint16_t timeout;
+};
+
+// interval in 1.25 ms units, supervision timeout in 10 ms units, indexed by BLEConnectionProfile
+static constexpr RequestedConnParams requestedConnParams[] = {
+    {0, 0, 0, 0},
+    {6, 6, 0, 400},
+    {12, 24, 0, 400},
+    {40, 80, 4, 600},
+};
+
+/**
+ * @brief Requests the connection parameters of the connection profile. The controller may reject them or pick
+ * different values within the requested range.
+ * @return True if the request was sent or no parameters are requested by the profile, false otherwise.
+ */
+bool BLEAbstractController::applyConnectionProfile() {
+  auto profile = _connectionProfile.load();
+  if (profile == BLEConnectionProfile::Default) {
+    return true;
+  }
+
+  if (profile == BLEConnectionProfile::Adaptive) {
+    const auto nowUs = esp_timer_get_time();
+    _lastActivityUs = nowUs;
+    _idle = false;
+    _modeRequestPending = false;
+
+    configASSERT(xSemaphoreTake(_timingsMutex, portMAX_DELAY));
+    _modeSinceUs = nowUs;
+    configASSERT(xSemaphoreGive(_timingsMutex));
+
+    xTimerStart(_idleTimer, portMAX_DELAY);
+    profile = BLEConnectionProfile::LowestLatency;
+  }
+
+  const auto& params = requestedConnParams[static_cast<uint8_t>(profile)];
+  BLEGC_LOGD("Requesting connection parameters, interval: %d-%d, latency: %d, timeout: %d", params.minInterval,
+             params.maxInterval, params.latency, params.timeout);
+  return _pClient->updateConnParams(params.minInterval, params.maxInterval, params.latency, params.timeout);
+}
+
+/**
+ * @brief Returns the time spent with the active and the idle connection parameters of the adaptive connection profile,
+ * since the controller instance was created.
+ * @return Adaptive connection statistics.
+ */
+BLEAdaptiveConnectionStats BLEAbstractController::getAdaptiveConnectionStats() const {
+  const auto nowUs = esp_timer_get_time();
+
+  configASSERT(xSemaphoreTake(_timingsMutex, portMAX_DELAY));
+  auto activeUs = _activeModeUs;
+  auto idleUs = _idleModeUs;
+  if (_modeSinceUs != 0) {
+    (_idle ? idleUs : activeUs) += nowUs - _modeSinceUs;
+  }
+  BLEAdaptiveConnectionStats stats{activeUs / 1000, idleUs / 1000, _modeSwitches};
+  configASSERT(xSemaphoreGive(_timingsMutex));
+
+  return stats;
+}
+
+/**
+ * @brief Records input activity for the adaptive connection profile. Called by the controls receiver whenever a
+ * decoded report changes the controls, never blocks.
+ * @param pArg Pointer to the controller.
+ */
+void BLEAbstractController::reportActivity(void* pArg) {
+  auto* self = static_cast<BLEAbstractController*>(pArg);
+  if (self->_connectionProfile != BLEConnectionProfile::Adaptive) {
+    return;
+  }
+
+  self->_lastActivityUs.store(esp_timer_get_time(), std::memory_order_relaxed);
+  if (self->_idle && !self->_switchPending.exchange(true) && !BLEDispatcher::post(_switchModeFn, self)) {
+    self->_switchPending = false;
+  }
+}
+
+void BLEAbstractController::_idleTimerFn(TimerHandle_t timer) {
+  auto* self = static_cast<BLEAbstractController*>(pvTimerGetTimerID(timer));
+  const auto quietUs = esp_timer_get_time() - self->_lastActivityUs.load(std::memory_order_relaxed);
+  if (!self->_idle && quietUs >= CONFIG_BT_BLEGC_ADAPTIVE_IDLE_TIMEOUT_MS * 1000ll &&
+      !self->_switchPending.exchange(true) && !BLEDispatcher::post(_switchModeFn, self)) {
+    self->_switchPending = false;
+  }
+}
+
+void BLEAbstractController::_switchModeFn(void* pArg) {
+  auto* self = static_cast<BLEAbstractController*>(pArg);
+  self->_switchPending = false;
+
+  auto* pClient = self->getClient();
+  if (!self->isConnected() || !pClient || self->_connectionProfile != BLEConnectionProfile::Adaptive) {
+    return;
+  }
+
+  // decide on the latest activity, it may have changed since the switch was scheduled
+  const auto nowUs = esp_timer_get_time();
+  const bool idle = nowUs - self->_lastActivityUs.load(std::memory_order_relaxed) >=
+                    CONFIG_BT_BLEGC_ADAPTIVE_IDLE_TIMEOUT_MS * 1000ll;
+  if (idle == self->_idle || (self->_modeRequestPending && idle == self->_requestedIdle)) {
+    return;
+  }
+
+  // the mode switches once the controller accepts the parameters, see `onConnParamsUpdated()`
+  self->_requestedIdle = idle;
+  self->_modeRequestPending = true;
+  const auto profile = idle ? BLEConnectionProfile::BatterySaver : BLEConnectionProfile::LowestLatency;
+  const auto& params = requestedConnParams[static_cast<uint8_t>(profile)];
+  if (!pClient->updateConnParams(params.minInterval, params.maxInterval, params.latency, params.timeout)) {
+    self->_modeRequestPending = false;
+    BLEGC_LOGW("Failed to request %s connection parameters", idle ? "idle" : "active");
+    return;
+  }
+  BLEGC_LOGD("Requested %s connection parameters", idle ? "idle" : "active");
+}
+
+/**
+ * @brief Called once the controller accepted new connection parameters. Completes the switch between the active and
+ * the idle parameters of the adaptive connection profile, if one was requested.
+ */
+void BLEAbstractController::onConnParamsUpdated() {
+  if (!_modeRequestPending.exchange(false)) {
+    return;
+  }
+
+  const bool idle = _requestedIdle;
+  configASSERT(xSemaphoreTake(_timingsMutex, portMAX_DELAY));
+  _accountModeTime(esp_timer_get_time());
+  _modeSwitches++;
+  _idle = idle;
+  configASSERT(xSemaphoreGive(_timingsMutex));
+  BLEGC_LOGD("Switched to %s connection parameters", idle ? "idle" : "active");
+}
+
+// must be called with the timings mutex held
+void BLEAbstractController::_accountModeTime(const int64_t nowUs) {
+  if (_modeSinceUs == 0) {
+    return;
+  }
+
+  (_idle ? _idleModeUs : _activeModeUs) += nowUs - _modeSinceUs;
+  _modeSinceUs = nowUs;
+}
+
+/**
+ * @brief Records the time at which a connection stage was reached. Reaching `Allocated` starts a new connection
+ * attempt, reaching `MarkedConnected` adds the attempt to the history the statistics are computed from.
+ * @param stage Reached stage.
+ * @param timestampUs Time at which the stage was reached, in microseconds since boot.
+ */
+void BLEAbstractController::markStage(const BLEConnectionStage stage, const int64_t timestampUs) {
+  // the first stages are marked from the scan callback, only completing the attempt takes the mutex
+  auto& timings = _timings.beginWrite();
+  if (stage == BLEConnectionStage::Allocated) {
+    timings = BLEConnectionTimings();
+  }
+  timings.stageUs[static_cast<uint8_t>(stage)] = timestampUs;
+  _timings.endWrite();
+
+  if (stage == BLEConnectionStage::MarkedConnected) {
+    // this is the only writer, so the timings can still be read after publishing them
+    configASSERT(xSemaphoreTake(_timingsMutex, portMAX_DELAY));
+    _timingsHistory[_timingsHistoryHead] = timings;
+    _timingsHistoryHead = (_timingsHistoryHead + 1) % CONFIG_BT_BLEGC_CONN_TIMINGS_HISTORY;
+    if (_timingsHistoryCount < CONFIG_BT_BLEGC_CONN_TIMINGS_HISTORY) {
+      _timingsHistoryCount++;
+    }
+    configASSERT(xSemaphoreGive(_timingsMutex));
+  }
+}
+
+/**
+ * @brief Returns the times at which the stages of the current or the latest connection attempt were reached.
+ * @return Timings of the connection attempt.
+ */
+BLEConnectionTimings BLEAbstractController::getConnectionTimings() const {
+  BLEConnectionTimings timings;
+  _timings.read(&timings);
+  return timings;
+}
+
+static void addDuration(BLEDurationStats& stats, const int64_t durationUs, const bool first) {
+  stats.minUs = first || durationUs < stats.minUs ? durationUs : stats.minUs;
+  stats.maxUs = first || durationUs > stats.maxUs ? durationUs : stats.maxUs;
+  stats.avgUs += durationUs;
+}
+
+/**
+ * @brief Returns the minimal, average and maximal time spent in each stage over the most recent successful
+ * connections, see `CONFIG_BT_BLEGC_CONN_TIMINGS_HISTORY`.
+ * @return Connection timing statistics.
+ */
+BLEConnectionTimingStats BLEAbstractController::getConnectionTimingStats() const {
+  BLEConnectionTimingStats stats;
+
+  configASSERT(xSemaphoreTake(_timingsMutex, portMAX_DELAY));
+  for (size_t i = 0; i < _timingsHistoryCount; i++) {
+    const auto& timings = _timingsHistory[i];
+    const auto first = i == 0;
+    const auto totalUs =
+        timings.at(BLEConnectionStage::MarkedConnected) - timings.at(BLEConnectionStage::Allocated);
+    addDuration(stats.total, totalUs, first);
+    for (uint8_t stage = 1; stage < BLEConnectionStageCount; stage++) {
+      // a stage skipped in this attempt counts as taking no time
+      const auto prevUs = timings.stageUs[stage - 1];
+      const auto durationUs = timings.stageUs[stage] != 0 && prevUs != 0 ? timings.stageUs[stage] - prevUs : 0;
+      addDuration(stats.stages[stage], durationUs, first);
+    }
+  }
+  stats.connections = _timingsHistoryCount;
+  configASSERT(xSemaphoreGive(_timingsMutex));
+
+  if (stats.connections > 0) {
+    stats.total.avgUs /= stats.connections;
+    for (auto& stage : stats.stages) {
+      stage.avgUs /= stats.connections;
+    }
+  }
+  return stats;
 }
 
 NimBLEClient* BLEAbstractController::getClient() const {
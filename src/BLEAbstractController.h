@@ -3,11 +3,16 @@
 #include <NimBLEDevice.h>
 #include <atomic>
 #include <memory>
+#include "BLEAdvMatchRule.h"
+#include "BLEConnectionProfile.h"
+#include "BLEConnectionTimings.h"
 #include "BLEDeviceInfo.h"
+#include "BLEValueSnapshot.h"
+#include "config.h"
 
 class BLEAbstractController {
  public:
-  virtual ~BLEAbstractController() = default;
+  virtual ~BLEAbstractController();
   explicit BLEAbstractController();
 
   void begin();
@@ -17,6 +22,12 @@ class BLEAbstractController {
   bool isConnected() const;
   bool isConnecting() const;
   void disconnect();
+  void setConnectionProfile(BLEConnectionProfile profile);
+  BLEConnectionProfile getConnectionProfile() const;
+  BLEConnectionParams getConnectionParams() const;
+  BLEAdaptiveConnectionStats getAdaptiveConnectionStats() const;
+  BLEConnectionTimings getConnectionTimings() const;
+  BLEConnectionTimingStats getConnectionTimingStats() const;
 
   friend class BLEUserCallbackRunner;
   friend class BLEControllerRegistry;
@@ -39,24 +50,60 @@ class BLEAbstractController {
   void markDisconnected();
   bool isPendingDeregistration() const;
   bool hidInit();
+  void markStage(BLEConnectionStage stage, int64_t timestampUs);
+  bool applyConnectionProfile();
+  void onConnParamsUpdated();
+  static void reportActivity(void* pArg);
+  void invalidateCache();
 
   virtual void callOnConnecting() = 0;
   virtual void callOnConnectionFailed() = 0;
   virtual void callOnConnected() = 0;
   virtual void callOnDisconnected() = 0;
-  virtual bool isSupported(const NimBLEAdvertisedDevice* pAdvertisedDevice) = 0;
+  virtual BLEAdvMatchRules getMatchRules() const = 0;
   virtual bool init() = 0;
   virtual bool deinit() = 0;
 
   static uint64_t _encodeAddress(const NimBLEAddress& address);
   static NimBLEAddress _decodeAddress(const uint64_t& address);
-  void _readDeviceInfo();
+  bool _readDeviceInfo();
+  void _accountModeTime(int64_t nowUs);
+  static void _idleTimerFn(TimerHandle_t timer);
+  static void _switchModeFn(void* pArg);
+  bool _loadCache();
+  void _storeCache();
+  std::string _cacheKey() const;
 
   std::atomic_bool _pendingDeregistration;
   std::atomic_uint64_t _address;
   NimBLEClient* _pClient;
 
   ConnectionState _connectionState;
-  NimBLEAddress _lastAddress;
+  // written by the registry with its mutex held, read by the scan callback without it
+  BLEValueSnapshot<NimBLEAddress> _lastAddress;
+  // encoded address last read from or written to the storage as the preferred address, 0 if none, accessed only by
+  // the registry
+  uint64_t _storedAddress;
   BLEDeviceInfo _deviceInfo;
+  std::vector<uint8_t> _reportMap;
+  bool _cacheLoaded;
+  std::atomic<BLEConnectionProfile> _connectionProfile;
+  TimerHandle_t _idleTimer;
+  std::atomic<int64_t> _lastActivityUs;
+  std::atomic_bool _idle;
+  std::atomic_bool _switchPending;
+  std::atomic_bool _modeRequestPending;
+  std::atomic_bool _requestedIdle;
+
+  SemaphoreHandle_t _timingsMutex;
+  // stages are marked by the scan callback and the registry task in turn, never concurrently, so the current attempt
+  // is written without the mutex
+  BLEValueSnapshot<BLEConnectionTimings> _timings;
+  BLEConnectionTimings _timingsHistory[CONFIG_BT_BLEGC_CONN_TIMINGS_HISTORY];
+  size_t _timingsHistoryHead;
+  size_t _timingsHistoryCount;
+  int64_t _modeSinceUs;
+  uint64_t _activeModeUs;
+  uint64_t _idleModeUs;
+  uint32_t _modeSwitches;
 };
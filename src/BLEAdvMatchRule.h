@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Advertisement fields accepted by a controller type. An advertisement matches the rule if every field set in
+ * the rule matches, an advertisement matching any of the rules of a controller type is supported by it.
+ *
+ * Rules are declared as constants, e.g. `BLEAdvMatchRule().withAppearance(gamepadAppearance)`, and compiled by the
+ * controller registry into a single matcher for all registered controllers.
+ */
+struct BLEAdvMatchRule {
+  enum Field : uint8_t {
+    /// @brief Complete local name equal to `name`.
+    CompleteName = 1 << 0,
+    /// @brief Shortened local name equal to `name`.
+    ShortenedName = 1 << 1,
+    /// @brief No complete local name.
+    NoName = 1 << 2,
+    /// @brief Appearance equal to `appearance`.
+    Appearance = 1 << 3,
+    /// @brief Manufacturer specific data with the company identifier `companyId`.
+    CompanyId = 1 << 4,
+    /// @brief 16-bit service UUID `serviceUUID` in the list of service UUIDs.
+    ServiceUUID = 1 << 5,
+  };
+
+  uint8_t fields{0};
+  const char* name{nullptr};
+  uint16_t appearance{0};
+  uint16_t companyId{0};
+  uint16_t serviceUUID{0};
+
+  constexpr BLEAdvMatchRule withCompleteName(const char* completeName) const {
+    auto rule = *this;
+    rule.fields |= CompleteName;
+    rule.name = completeName;
+    return rule;
+  }
+
+  constexpr BLEAdvMatchRule withShortenedName(const char* shortenedName) const {
+    auto rule = *this;
+    rule.fields |= ShortenedName;
+    rule.name = shortenedName;
+    return rule;
+  }
+
+  constexpr BLEAdvMatchRule withoutName() const {
+    auto rule = *this;
+    rule.fields |= NoName;
+    return rule;
+  }
+
+  constexpr BLEAdvMatchRule withAppearance(const uint16_t value) const {
+    auto rule = *this;
+    rule.fields |= Appearance;
+    rule.appearance = value;
+    return rule;
+  }
+
+  constexpr BLEAdvMatchRule withCompanyId(const uint16_t value) const {
+    auto rule = *this;
+    rule.fields |= CompanyId;
+    rule.companyId = value;
+    return rule;
+  }
+
+  constexpr BLEAdvMatchRule withServiceUUID(const uint16_t value) const {
+    auto rule = *this;
+    rule.fields |= ServiceUUID;
+    rule.serviceUUID = value;
+    return rule;
+  }
+};
+
+/**
+ * @brief Match rules of a controller type. All instances of a type return the same array, which lets the matcher
+ * evaluate the rules once for all of them.
+ */
+struct BLEAdvMatchRules {
+  const BLEAdvMatchRule* pRules;
+  size_t count;
+};
@@ -0,0 +1,216 @@
+#include "BLEAdvMatcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include "logger.h"
+
+constexpr size_t maxServiceUUIDs = 8;
+
+struct AdvFields {
+  const uint8_t* pName;
+  uint8_t nameLen;
+  uint32_t nameHash;
+  const uint8_t* pShortName;
+  uint8_t shortNameLen;
+  uint32_t shortNameHash;
+  bool haveAppearance;
+  uint16_t appearance;
+  bool haveCompanyId;
+  uint16_t companyId;
+  uint16_t serviceUUIDs[maxServiceUUIDs];
+  uint8_t serviceUUIDCount;
+};
+
+// FNV-1a, names are short and compared only on a hash match
+static uint32_t hashName(const uint8_t* pName, const size_t nameLen) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < nameLen; i++) {
+    hash = (hash ^ pName[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static uint16_t readUInt16(const uint8_t* pData) {
+  return pData[1] << 8 | pData[0];  // low endian to native endian conversion
+}
+
+// walks the advertisement data once, the fields point into the payload and are valid as long as the advertised device
+static void parseAdvFields(const NimBLEAdvertisedDevice* pAdvertisedDevice, AdvFields* pFields) {
+  *pFields = {};
+
+  const auto& payload = pAdvertisedDevice->getPayload();
+  const auto* pPayload = payload.data();
+  const size_t payloadLen = payload.size();
+
+  // each field is a length byte, covering the type byte and the data, followed by the type byte and the data
+  size_t pos = 0;
+  while (pos + 1 < payloadLen) {
+    const uint8_t fieldLen = pPayload[pos];
+    if (fieldLen == 0 || pos + 1 + fieldLen > payloadLen) {
+      break;
+    }
+
+    const uint8_t type = pPayload[pos + 1];
+    const uint8_t* pData = &pPayload[pos + 2];
+    const uint8_t dataLen = fieldLen - 1;
+    pos += 1 + fieldLen;
+
+    switch (type) {
+      case BLE_HS_ADV_TYPE_COMP_NAME:
+        pFields->pName = pData;
+        pFields->nameLen = dataLen;
+        pFields->nameHash = hashName(pData, dataLen);
+        break;
+      case BLE_HS_ADV_TYPE_INCOMP_NAME:
+        pFields->pShortName = pData;
+        pFields->shortNameLen = dataLen;
+        pFields->shortNameHash = hashName(pData, dataLen);
+        break;
+      case BLE_HS_ADV_TYPE_APPEARANCE:
+        if (dataLen >= 2) {
+          pFields->haveAppearance = true;
+          pFields->appearance = readUInt16(pData);
+        }
+        break;
+      case BLE_HS_ADV_TYPE_MFG_DATA:
+        // the first manufacturer data field identifies the device, later ones must not replace it
+        if (dataLen >= 2 && !pFields->haveCompanyId) {
+          pFields->haveCompanyId = true;
+          pFields->companyId = readUInt16(pData);
+        }
+        break;
+      case BLE_HS_ADV_TYPE_INCOMP_UUIDS16:
+      case BLE_HS_ADV_TYPE_COMP_UUIDS16:
+        for (size_t i = 0; i + 1 < dataLen && pFields->serviceUUIDCount < maxServiceUUIDs; i += 2) {
+          pFields->serviceUUIDs[pFields->serviceUUIDCount++] = readUInt16(&pData[i]);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+static bool nameMatches(const uint8_t* pName, const uint8_t nameLen, const uint32_t nameHash, const char* ruleName,
+                        const uint8_t ruleNameLen, const uint32_t ruleNameHash) {
+  return pName && nameLen == ruleNameLen && nameHash == ruleNameHash && memcmp(pName, ruleName, nameLen) == 0;
+}
+
+/**
+ * @brief Compiles the match rules of all slots. Slots whose controllers share the same rules array are grouped into
+ * a single controller type. Must not be called concurrently with itself.
+ * @param rulesBySlot Match rules of each slot, a slot without rules is never matched.
+ * @param slotCount Number of slots, at most `maxSlots`.
+ */
+void BLEAdvMatcher::compile(const BLEAdvMatchRules rulesBySlot[], const size_t slotCount) {
+  configASSERT(slotCount <= maxSlots);
+
+  // types are identified by their rules array while compiling
+  const BLEAdvMatchRule* typeRules[maxSlots];
+
+  auto& table = _table.beginWrite();
+  table.ruleCount = 0;
+  table.typeCount = 0;
+
+  for (size_t slot = 0; slot < slotCount; slot++) {
+    const auto& rules = rulesBySlot[slot];
+    if (rules.count == 0) {
+      continue;
+    }
+
+    size_t type = 0;
+    while (type < table.typeCount && typeRules[type] != rules.pRules) {
+      type++;
+    }
+    if (type < table.typeCount) {
+      table.typeSlots[type] |= 1u << slot;
+      continue;
+    }
+
+    if (table.ruleCount + rules.count > CONFIG_BT_BLEGC_ADV_MATCH_MAX_RULES) {
+      BLEGC_LOGE("Too many advertisement match rules, controller in slot %zu will not be matched", slot);
+      continue;
+    }
+
+    typeRules[type] = rules.pRules;
+    table.typeSlots[type] = 1u << slot;
+    table.typeCount++;
+
+    for (size_t i = 0; i < rules.count; i++) {
+      const auto& rule = rules.pRules[i];
+      const size_t nameLen = rule.name ? strlen(rule.name) : 0;
+      auto& compiled = table.rules[table.ruleCount++];
+      compiled.fields = rule.fields;
+      compiled.type = type;
+      compiled.nameLen = nameLen;
+      compiled.nameHash = hashName(reinterpret_cast<const uint8_t*>(rule.name), nameLen);
+      compiled.name = rule.name;
+      compiled.appearance = rule.appearance;
+      compiled.companyId = rule.companyId;
+      compiled.serviceUUID = rule.serviceUUID;
+    }
+  }
+
+  _table.endWrite();
+}
+
+/**
+ * @brief Classifies an advertisement. Does not allocate and never blocks on `compile()`.
+ * @param pAdvertisedDevice Advertised device.
+ * @return Controller types and slots whose rules the advertisement matches.
+ */
+BLEAdvMatcher::Result BLEAdvMatcher::classify(const NimBLEAdvertisedDevice* pAdvertisedDevice) const {
+  AdvFields adv;
+  parseAdvFields(pAdvertisedDevice, &adv);
+
+  // only the rules in use are copied, the counts of a torn read are clamped so that the copies can't overrun
+  CompiledRule rules[CONFIG_BT_BLEGC_ADV_MATCH_MAX_RULES];
+  uint32_t typeSlots[maxSlots];
+  size_t ruleCount = 0;
+  _table.read([&](const Table& table) {
+    ruleCount = std::min<size_t>(table.ruleCount, CONFIG_BT_BLEGC_ADV_MATCH_MAX_RULES);
+    const auto typeCount = std::min<size_t>(table.typeCount, maxSlots);
+    std::copy_n(table.rules, ruleCount, rules);
+    std::copy_n(table.typeSlots, typeCount, typeSlots);
+  });
+
+  Result result{0, 0};
+  for (size_t i = 0; i < ruleCount; i++) {
+    const auto& rule = rules[i];
+    if (result.types & 1u << rule.type) {
+      continue;
+    }
+
+    if (rule.fields & BLEAdvMatchRule::CompleteName &&
+        !nameMatches(adv.pName, adv.nameLen, adv.nameHash, rule.name, rule.nameLen, rule.nameHash)) {
+      continue;
+    }
+    if (rule.fields & BLEAdvMatchRule::ShortenedName &&
+        !nameMatches(adv.pShortName, adv.shortNameLen, adv.shortNameHash, rule.name, rule.nameLen, rule.nameHash)) {
+      continue;
+    }
+    if (rule.fields & BLEAdvMatchRule::NoName && adv.pName) {
+      continue;
+    }
+    if (rule.fields & BLEAdvMatchRule::Appearance && (!adv.haveAppearance || adv.appearance != rule.appearance)) {
+      continue;
+    }
+    if (rule.fields & BLEAdvMatchRule::CompanyId && (!adv.haveCompanyId || adv.companyId != rule.companyId)) {
+      continue;
+    }
+    if (rule.fields & BLEAdvMatchRule::ServiceUUID) {
+      bool found = false;
+      for (size_t j = 0; j < adv.serviceUUIDCount && !found; j++) {
+        found = adv.serviceUUIDs[j] == rule.serviceUUID;
+      }
+      if (!found) {
+        continue;
+      }
+    }
+
+    result.types |= 1u << rule.type;
+    result.slots |= typeSlots[rule.type];
+  }
+
+  return result;
+}
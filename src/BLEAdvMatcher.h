@@ -0,0 +1,52 @@
+#pragma once
+
+#include <NimBLEDevice.h>
+#include <cstdint>
+#include "BLEAdvMatchRule.h"
+#include "BLEValueSnapshot.h"
+#include "config.h"
+
+/**
+ * @brief Classifies advertisements against the match rules of all registered controllers.
+ *
+ * The advertisement data is walked once, then every distinct rule is compared against the extracted fields. Rules are
+ * grouped by controller type, so the cost depends on the number of controller types, not on the number of instances.
+ */
+class BLEAdvMatcher {
+ public:
+  struct Result {
+    /// @brief Bit `i` is set if the advertisement matches the `i`-th controller type passed to `compile()`.
+    uint32_t types;
+    /// @brief Bit `i` is set if the advertisement matches the rules of slot `i`.
+    uint32_t slots;
+  };
+
+  static constexpr size_t maxSlots = 32;
+
+  BLEAdvMatcher() = default;
+
+  void compile(const BLEAdvMatchRules rulesBySlot[], size_t slotCount);
+  Result classify(const NimBLEAdvertisedDevice* pAdvertisedDevice) const;
+
+ private:
+  struct CompiledRule {
+    uint8_t fields;
+    uint8_t type;
+    uint8_t nameLen;
+    uint32_t nameHash;
+    const char* name;
+    uint16_t appearance;
+    uint16_t companyId;
+    uint16_t serviceUUID;
+  };
+
+  struct Table {
+    CompiledRule rules[CONFIG_BT_BLEGC_ADV_MATCH_MAX_RULES];
+    uint8_t ruleCount;
+    uint8_t typeCount;
+    uint32_t typeSlots[maxSlots];
+  };
+
+  // written by the registry with its mutex held, read by the scan callback without a lock
+  BLEValueSnapshot<Table> _table;
+};
@@ -1,6 +1,8 @@
 #include "BLEAutoScan.h"
 
 #include <NimBLEDevice.h>
+#include <esp_timer.h>
+#include <algorithm>
 #include "BLEControllerRegistry.h"
 #include "logger.h"
 #include "messages.h"
@@ -15,7 +17,18 @@ BLEAutoScan::BLEAutoScan(BLEControllerRegistry& controllerRegistry,
       _scanCallbacksImpl(*this),
       _onScanStarted([]() {}),
       _onScanStopped([]() {}),
-      _userCallbackQueue(userCallbackQueue) {
+      _userCallbackQueue(userCallbackQueue),
+      _statsMutex(xSemaphoreCreateMutex()),
+      _scanStats(),
+      _scanStartUs(0),
+      _scanRunning(false),
+      _scanUsesAcceptList(false),
+      _scanWindowMs(0),
+      _scanIntervalMs(0),
+      _acceptListSinceUs(0),
+      _connectUs(0) {
+  configASSERT(_statsMutex);
+
   xTaskCreate(_autoScanTaskFn, "_autoScanTaskFn", 10000, this, 0, &_autoScanTask);
   configASSERT(_autoScanTask);
 
@@ -28,6 +41,10 @@ BLEAutoScan::~BLEAutoScan() {
     vTaskDelete(_autoScanTask);
     _autoScanTask = nullptr;
   }
+  if (_statsMutex != nullptr) {
+    vSemaphoreDelete(_statsMutex);
+    _statsMutex = nullptr;
+  }
 }
 
 /**
@@ -81,6 +98,36 @@ void BLEAutoScan::notify() const {
   xTaskNotify(_autoScanTask, static_cast<uint8_t>(BLEAutoScanNotification::Auto), eSetValueWithOverwrite);
 }
 
+/**
+ * @brief Enables or disables accept list scanning, see `CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_ENABLED`. Applies to scans
+ * started afterwards.
+ * @param enabled True to scan with the accept list whenever possible, false to always scan for any device.
+ */
+void BLEAutoScan::setAcceptListScan(const bool enabled) {
+  _acceptListScan = enabled;
+}
+
+bool BLEAutoScan::isAcceptListScan() const {
+  return _acceptListScan;
+}
+
+/**
+ * @brief Returns the scan time, airtime and discovery latency of the scans, separately for scans with and without
+ * the accept list. Includes the scan in progress.
+ * @return Scan statistics.
+ */
+BLEScanStats BLEAutoScan::getScanStats() const {
+  const auto nowUs = esp_timer_get_time();
+  const auto connectUs = _connectUs.load();
+
+  configASSERT(xSemaphoreTake(_statsMutex, portMAX_DELAY));
+  auto stats = _scanStats;
+  _accountScan(stats, nowUs, connectUs);
+  configASSERT(xSemaphoreGive(_statsMutex));
+
+  return stats;
+}
+
 void BLEAutoScan::onScanStarted(const std::function<void()>& callback) {
   _onScanStarted = callback;
 }
@@ -103,26 +150,149 @@ void BLEAutoScan::_sendUserCallbackMsg(const BLEUserCallback& msg) const {
   }
 }
 
-void BLEAutoScan::_startScan(NimBLEScan* pScan, bool highDuty) {
+void BLEAutoScan::_startScan(NimBLEScan* pScan, bool highDuty, uint32_t durationMs) {
+  const auto nowUs = esp_timer_get_time();
+
+  // the accept list cannot be changed while scanning, a running scan is restarted anyway
+  if (pScan->isScanning()) {
+    pScan->stop();
+  }
+  _endScanStats(nowUs);
+
+  const auto acceptListTimeLeftUs = _acceptListTimeLeftUs(nowUs);
+  if (_acceptListScan && acceptListTimeLeftUs == 0) {
+    BLEGC_LOGD("Accept list scans did not connect a controller in time, scanning for any device");
+  }
+  const bool acceptList = _acceptListScan && acceptListTimeLeftUs > 0 && _programAcceptList();
+  pScan->setFilterPolicy(acceptList ? BLE_HCI_SCAN_FILT_USE_WL : BLE_HCI_SCAN_FILT_NO_WL);
+
+  // an accept list scan ends when it times out, so that the scan after it can fall back to scanning for any device
+  if (acceptList) {
+    durationMs = std::min<int64_t>(durationMs, (acceptListTimeLeftUs + 999) / 1000);
+  }
+
   if (highDuty) {
-    pScan->setWindow(CONFIG_BT_BLEGC_HIGH_DUTY_SCAN_WINDOW_MS);
-    pScan->setInterval(CONFIG_BT_BLEGC_HIGH_DUTY_SCAN_INTERVAL_MS);
+    const uint32_t windowMs =
+        acceptList ? CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_WINDOW_MS : CONFIG_BT_BLEGC_HIGH_DUTY_SCAN_WINDOW_MS;
+    const uint32_t intervalMs =
+        acceptList ? CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_INTERVAL_MS : CONFIG_BT_BLEGC_HIGH_DUTY_SCAN_INTERVAL_MS;
+    pScan->setWindow(windowMs);
+    pScan->setInterval(intervalMs);
     pScan->setActiveScan(CONFIG_BT_BLEGC_HIGH_DUTY_SCAN_ACTIVE > 0);
-    pScan->start(CONFIG_BT_BLEGC_HIGH_DUTY_SCAN_DURATION_MS);
+    _beginScanStats(nowUs, acceptList, windowMs, intervalMs);
+    pScan->start(durationMs);
   } else {
     pScan->setWindow(CONFIG_BT_BLEGC_LOW_DUTY_SCAN_WINDOW_MS);
     pScan->setInterval(CONFIG_BT_BLEGC_LOW_DUTY_SCAN_INTERVAL_MS);
     pScan->setActiveScan(CONFIG_BT_BLEGC_LOW_DUTY_SCAN_ACTIVE > 0);
-    pScan->start(CONFIG_BT_BLEGC_LOW_DUTY_SCAN_DURATION_MS);
+    _beginScanStats(nowUs, acceptList, CONFIG_BT_BLEGC_LOW_DUTY_SCAN_WINDOW_MS,
+                    CONFIG_BT_BLEGC_LOW_DUTY_SCAN_INTERVAL_MS);
+    pScan->start(durationMs);
   }
   _sendUserCallbackMsg({BLEUserCallbackKind::ScanStarted});
 }
 
 void BLEAutoScan::_stopScan(NimBLEScan* pScan) {
   pScan->stop();
+  _endScanStats(esp_timer_get_time());
   _sendUserCallbackMsg({BLEUserCallbackKind::ScanStopped});
 }
 
+// replaces the accept list with the addresses the waiting controllers can reconnect to, returns false if a scan for
+// any device is needed
+bool BLEAutoScan::_programAcceptList() {
+  NimBLEAddress addresses[CONFIG_BT_BLEGC_MAX_CONTROLLERS];
+  size_t count = 0;
+  if (!_controllerRegistry.getReconnectAddresses(addresses, &count)) {
+    return false;
+  }
+
+  while (NimBLEDevice::getWhiteListCount() > 0) {
+    if (!NimBLEDevice::whiteListRemove(NimBLEDevice::getWhiteListAddress(0))) {
+      BLEGC_LOGE("Failed to clear the accept list");
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    if (!NimBLEDevice::onWhiteList(addresses[i]) && !NimBLEDevice::whiteListAdd(addresses[i])) {
+      BLEGC_LOGE("Failed to add an address to the accept list");
+      return false;
+    }
+  }
+
+  // a controller may also connect to another bonded device
+  for (int i = 0; i < NimBLEDevice::getNumBonds(); i++) {
+    const auto address = NimBLEDevice::getBondedAddress(i);
+    if (!NimBLEDevice::onWhiteList(address) && !NimBLEDevice::whiteListAdd(address)) {
+      BLEGC_LOGE("Failed to add an address to the accept list");
+      return false;
+    }
+  }
+
+  BLEGC_LOGD("Accept list programmed, addresses: %zu", NimBLEDevice::getWhiteListCount());
+  return NimBLEDevice::getWhiteListCount() > 0;
+}
+
+// time accept list scans may still take before falling back to scans for any device, a controller that was reset or
+// changes its address would otherwise never be found
+int64_t BLEAutoScan::_acceptListTimeLeftUs(const int64_t nowUs) const {
+  configASSERT(xSemaphoreTake(_statsMutex, portMAX_DELAY));
+  const auto sinceUs = _acceptListSinceUs;
+  configASSERT(xSemaphoreGive(_statsMutex));
+
+#if CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_TIMEOUT_MS > 0
+  const int64_t timeoutUs = CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_TIMEOUT_MS * 1000ll;
+  return sinceUs == 0 ? timeoutUs : std::max<int64_t>(0, sinceUs + timeoutUs - nowUs);
+#else
+  return INT64_MAX;
+#endif
+}
+
+void BLEAutoScan::_beginScanStats(const int64_t nowUs, const bool acceptList, const uint32_t windowMs,
+                                  const uint32_t intervalMs) {
+  configASSERT(xSemaphoreTake(_statsMutex, portMAX_DELAY));
+  _scanStartUs = nowUs;
+  _scanRunning = true;
+  _scanUsesAcceptList = acceptList;
+  _scanWindowMs = windowMs;
+  _scanIntervalMs = intervalMs;
+  (acceptList ? _scanStats.acceptList : _scanStats.open).scans++;
+  if (acceptList && _acceptListSinceUs == 0) {
+    _acceptListSinceUs = nowUs;
+  }
+  configASSERT(xSemaphoreGive(_statsMutex));
+}
+
+// accounts the scan in progress, if any, as ended at the given time, or when it initiated a connection. Called only by
+// the auto-scan task.
+void BLEAutoScan::_endScanStats(const int64_t nowUs) {
+  const auto connectUs = _connectUs.exchange(0);
+
+  configASSERT(xSemaphoreTake(_statsMutex, portMAX_DELAY));
+  _accountScan(_scanStats, nowUs, connectUs);
+  _scanRunning = false;
+  // the controllers waiting after a connection may be found by accept list scans again
+  if (connectUs != 0) {
+    _acceptListSinceUs = 0;
+  }
+  configASSERT(xSemaphoreGive(_statsMutex));
+}
+
+// adds the scan in progress and the connection it initiated, if any, to the stats, must be called with the mutex held
+void BLEAutoScan::_accountScan(BLEScanStats& stats, const int64_t nowUs, const int64_t connectUs) const {
+  auto& modeStats = _scanUsesAcceptList ? stats.acceptList : stats.open;
+  if (_scanRunning) {
+    const uint64_t scanUs = (connectUs != 0 ? std::min(connectUs, nowUs) : nowUs) - _scanStartUs;
+    modeStats.scanUs += scanUs;
+    modeStats.airtimeUs += scanUs * _scanWindowMs / _scanIntervalMs;
+  }
+  if (connectUs != 0) {
+    modeStats.connects++;
+    modeStats.discoveryUs += connectUs - _scanStartUs;
+  }
+}
+
 void BLEAutoScan::_autoScanTaskFn(void* pvParameters) {
   auto* self = static_cast<BLEAutoScan*>(pvParameters);
 
@@ -142,13 +312,17 @@ void BLEAutoScan::_autoScanTaskFn(void* pvParameters) {
     const auto currTimeMs = millis();
     std::string decision = "no action";
 
+    if (!isScanning) {
+      self->_endScanStats(esp_timer_get_time());
+    }
+
     switch (notification) {
       case BLEAutoScanNotification::Auto:
       case BLEAutoScanNotification::Enabled: {
         if (isEnabled && canAllocateCtrl) {
           decision = "start high duty scan";
           self->_startTimeMs = currTimeMs;
-          self->_startScan(pScan, true);
+          self->_startScan(pScan, true, CONFIG_BT_BLEGC_HIGH_DUTY_SCAN_DURATION_MS);
         }
         break;
       }
@@ -177,7 +351,12 @@ void BLEAutoScan::_autoScanTaskFn(void* pvParameters) {
 
             if (currTimeMs > hdEndTimeMs && currTimeMs < ldEndTimeMs) {
               decision = "start low duty scan";
-              self->_startScan(pScan, false);
+              self->_startScan(pScan, false, CONFIG_BT_BLEGC_LOW_DUTY_SCAN_DURATION_MS);
+            } else if (currTimeMs < hdEndTimeMs && self->_acceptListScan &&
+                       self->_acceptListTimeLeftUs(esp_timer_get_time()) == 0) {
+              // the accept list scan timed out during the high duty phase, which continues with a scan for any device
+              decision = "fall back to high duty scan";
+              self->_startScan(pScan, true, hdEndTimeMs - currTimeMs);
             }
           }
         }
@@ -194,14 +373,18 @@ void BLEAutoScan::_autoScanTaskFn(void* pvParameters) {
 BLEAutoScan::ScanCallbacksImpl::ScanCallbacksImpl(BLEAutoScan& autoScan) : _autoScan(autoScan) {}
 
 void BLEAutoScan::ScanCallbacksImpl::onResult(const NimBLEAdvertisedDevice* pAdvertisedDevice) {
-  BLEGC_LOGD("Device discovered, address: %s, address type: %d, name: %s",
-             std::string(pAdvertisedDevice->getAddress()).c_str(), pAdvertisedDevice->getAddressType(),
-             pAdvertisedDevice->getName().c_str());
+  if (BLEGC_LOG_ENABLED(ESP_LOG_DEBUG)) {
+    BLEGC_LOGD("Device discovered, address: %s, address type: %d, name: %s",
+               std::string(pAdvertisedDevice->getAddress()).c_str(), pAdvertisedDevice->getAddressType(),
+               pAdvertisedDevice->getName().c_str());
+  }
 
-  _autoScan._controllerRegistry.tryConnectController(pAdvertisedDevice);
+  if (_autoScan._controllerRegistry.tryConnectController(pAdvertisedDevice)) {
+    _autoScan._connectUs = esp_timer_get_time();
+  }
 }
 
-void BLEAutoScan::ScanCallbacksImpl::onScanEnd(const NimBLEScanResults& results, int reason) {
+void BLEAutoScan::ScanCallbacksImpl::onScanEnd(const NimBLEScanResults&, int reason) {
   BLEGC_LOGD("Scan ended, reason: 0x%04x %s", reason, NimBLEUtils::returnCodeToString(reason));
   xTaskNotify(_autoScan._autoScanTask, static_cast<uint8_t>(BLEAutoScanNotification::ScanFinished),
               eSetValueWithOverwrite);
@@ -3,6 +3,33 @@
 #include "BLEControllerRegistry.h"
 #include "messages.h"
 
+struct BLEScanModeStats {
+  /// @brief Number of scans started.
+  uint32_t scans{0};
+
+  /// @brief Time spent scanning, in microseconds.
+  uint64_t scanUs{0};
+
+  /// @brief Time the radio spent receiving, i.e. the scan time weighted by the scan window and interval, in
+  /// microseconds.
+  uint64_t airtimeUs{0};
+
+  /// @brief Number of connections initiated from an advertisement received by a scan.
+  uint32_t connects{0};
+
+  /// @brief Total time from the start of a scan until a connection was initiated, in microseconds. Divided by
+  /// `connects`, it is the average discovery latency.
+  uint64_t discoveryUs{0};
+};
+
+struct BLEScanStats {
+  /// @brief Scans that report advertisements from any device.
+  BLEScanModeStats open{};
+
+  /// @brief Scans filtered by the accept list.
+  BLEScanModeStats acceptList{};
+};
+
 class BLEAutoScan {
  public:
   BLEAutoScan(BLEControllerRegistry& controllerRegistry,
@@ -15,6 +42,9 @@ class BLEAutoScan {
   bool isEnabled() const;
   bool isScanning() const;
   void notify() const;
+  void setAcceptListScan(bool enabled);
+  bool isAcceptListScan() const;
+  BLEScanStats getScanStats() const;
   void onScanStarted(const std::function<void()>& callback);
   void onScanStopped(const std::function<void()>& callback);
 
@@ -32,12 +62,18 @@ class BLEAutoScan {
   void callOnScanStarted();
   void callOnScanStopped();
   void _sendUserCallbackMsg(const BLEUserCallback& msg) const;
-  void _startScan(NimBLEScan* pScan, bool highDuty);
+  void _startScan(NimBLEScan* pScan, bool highDuty, uint32_t durationMs);
   void _stopScan(NimBLEScan* pScan);
+  bool _programAcceptList();
+  int64_t _acceptListTimeLeftUs(int64_t nowUs) const;
+  void _beginScanStats(int64_t nowUs, bool acceptList, uint32_t windowMs, uint32_t intervalMs);
+  void _endScanStats(int64_t nowUs);
+  void _accountScan(BLEScanStats& stats, int64_t nowUs, int64_t connectUs) const;
 
   static void _autoScanTaskFn(void* pvParameters);
 
   bool _enabled = true;
+  bool _acceptListScan = CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_ENABLED > 0;
   TaskHandle_t& _autoScanTask;
   unsigned long _startTimeMs;
   BLEControllerRegistry& _controllerRegistry;
@@ -45,4 +81,17 @@ class BLEAutoScan {
   std::function<void()> _onScanStarted;
   std::function<void()> _onScanStopped;
   QueueHandle_t& _userCallbackQueue;
+
+  SemaphoreHandle_t _statsMutex;
+  BLEScanStats _scanStats;
+  int64_t _scanStartUs;
+  bool _scanRunning;
+  bool _scanUsesAcceptList;
+  uint32_t _scanWindowMs;
+  uint32_t _scanIntervalMs;
+  // start of the accept list scans since the last connection, 0 if no accept list scan was started since
+  int64_t _acceptListSinceUs;
+  // set by the scan callback when it initiated a connection, which ended the scan, and accounted by the auto-scan task
+  // so that the scan callback never waits for the mutex
+  std::atomic<int64_t> _connectUs;
 };
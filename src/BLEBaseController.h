@@ -2,28 +2,46 @@
 
 #include <functional>
 #include "BLEAbstractController.h"
+#include "BLECallback.h"
 
 template <typename T>
 class BLEBaseController : public BLEAbstractController {
 public:
-  explicit BLEBaseController()
-      : _onConnecting([](T&) {}), _onConnectionFailed([](T&) {}), _onConnected([](T&) {}), _onDisconnected([](T&) {}) {}
+  using CallbackFn = typename BLECallback<T&>::Fn;
 
-  void onConnecting(const std::function<void(T&)>& callback) { _onConnecting = callback; }
+  explicit BLEBaseController() : _onConnecting(), _onConnectionFailed(), _onConnected(), _onDisconnected() {}
 
-  void onConnectionFailed(const std::function<void(T&)>& callback) { _onConnectionFailed = callback; }
+  void onConnecting(const std::function<void(T&)>& callback) { _onConnecting.set(callback); }
+  void onConnecting(CallbackFn callback, void* pArg) { _onConnecting.set(callback, pArg); }
+
+  void onConnectionFailed(const std::function<void(T&)>& callback) { _onConnectionFailed.set(callback); }
+  void onConnectionFailed(CallbackFn callback, void* pArg) { _onConnectionFailed.set(callback, pArg); }
 
   /**
    * @brief Sets the callback to be invoked when the controller connects.
    * @param callback Reference to a callback function.
    */
-  void onConnected(const std::function<void(T&)>& callback) { _onConnected = callback; }
+  void onConnected(const std::function<void(T&)>& callback) { _onConnected.set(callback); }
+
+  /**
+   * @brief Sets the callback to be invoked when the controller connects, without allocating.
+   * @param callback Pointer to the callback function.
+   * @param pArg Argument passed to the callback.
+   */
+  void onConnected(CallbackFn callback, void* pArg) { _onConnected.set(callback, pArg); }
 
   /**
    * @brief Sets the callback to be invoked when the controller disconnects.
    * @param callback Reference to the callback function.
    */
-  void onDisconnected(const std::function<void(T&)>& callback) { _onDisconnected = callback; }
+  void onDisconnected(const std::function<void(T&)>& callback) { _onDisconnected.set(callback); }
+
+  /**
+   * @brief Sets the callback to be invoked when the controller disconnects, without allocating.
+   * @param callback Pointer to the callback function.
+   * @param pArg Argument passed to the callback.
+   */
+  void onDisconnected(CallbackFn callback, void* pArg) { _onDisconnected.set(callback, pArg); }
 
 protected:
   void callOnConnecting() override { _onConnecting(*static_cast<T*>(this)); }
@@ -32,8 +50,8 @@ protected:
   void callOnDisconnected() override { _onDisconnected(*static_cast<T*>(this)); }
 
 private:
-  std::function<void(T&)> _onConnecting;
-  std::function<void(T&)> _onConnectionFailed;
-  std::function<void(T&)> _onConnected;
-  std::function<void(T&)> _onDisconnected;
+  BLECallback<T&> _onConnecting;
+  BLECallback<T&> _onConnectionFailed;
+  BLECallback<T&> _onConnected;
+  BLECallback<T&> _onDisconnected;
 };
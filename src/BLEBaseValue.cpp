@@ -4,7 +4,7 @@
 
 void BLEBaseValue::logReportDataHex() const {
 #if CONFIG_BT_BLEGC_LOG_BUFFER_ENABLED
-  BLEGC_LOGD_BUFFER_HEX(reportData.get(), reportDataLen);
+  BLEGC_LOGD_BUFFER_HEX(reportData, reportDataLen);
 #else
   BLEGC_LOGW("To use this function set CONFIG_BT_BLEGC_LOG_BUFFER_ENABLED to 1");
 #endif
@@ -12,7 +12,7 @@ void BLEBaseValue::logReportDataHex() const {
 
 void BLEBaseValue::logReportDataBin() const {
 #if CONFIG_BT_BLEGC_LOG_BUFFER_ENABLED
-  BLEGC_LOGD_BUFFER_BIN(reportData.get(), reportDataLen);
+  BLEGC_LOGD_BUFFER_BIN(reportData, reportDataLen);
 #else
   BLEGC_LOGW("To use this function set CONFIG_BT_BLEGC_LOG_BUFFER_ENABLED to 1");
 #endif
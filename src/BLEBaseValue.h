@@ -1,7 +1,8 @@
 #pragma once
 
 #include <NimBLEAddress.h>
-#include <memory>
+#include <cstring>
+#include "config.h"
 
 enum class BLEEncodeResult : uint8_t { Success = 0, InvalidValue = 1, BufferTooShort = 2 };
 
@@ -13,9 +14,15 @@ struct BLEBaseValue {
   NimBLEAddress controllerAddress{};
 
 #if CONFIG_BT_BLEGC_LOG_BUFFER_ENABLED
-  std::shared_ptr<uint8_t[]> reportData{nullptr};
+  /// @brief Report data attached to this value, truncated to CONFIG_BT_BLEGC_LOG_BUFFER_REPORT_MAX_LEN bytes.
+  uint8_t reportData[CONFIG_BT_BLEGC_LOG_BUFFER_REPORT_MAX_LEN]{};
   size_t reportDataLen{0};
-  size_t reportDataCap{0};
+
+  /// @brief Copies the report data into this value, truncating it if necessary. Never allocates.
+  void captureReportData(const uint8_t* data, const size_t dataLen) {
+    reportDataLen = dataLen < sizeof(reportData) ? dataLen : sizeof(reportData);
+    memcpy(reportData, data, reportDataLen);
+  }
 #endif
 
   /// @brief Logs in a hexadecimal format the report data attached to this value. To use this function set the config
@@ -25,4 +32,12 @@ struct BLEBaseValue {
   /// @brief Logs in a binary format the report data attached to this value. To use this function set the config
   /// param CONFIG_BT_BLEGC_LOG_BUFFER_ENABLED to 1.
   void logReportDataBin() const;
+
+ protected:
+  /// @brief Assigns the value to the field and sets the field's bit in the change mask if the value differs.
+  template <typename V>
+  static void setField(V& field, const V value, uint32_t& changedFields, const uint32_t fieldBit) {
+    changedFields |= field != value ? fieldBit : 0;
+    field = value;
+  }
 };
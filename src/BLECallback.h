@@ -0,0 +1,48 @@
+#pragma once
+
+#include <functional>
+
+/**
+ * @brief User callback stored as a function pointer and a context argument.
+ *
+ * Invoking a callback set from a function pointer is a single indirect call and never allocates. A `std::function` can
+ * be set as well for convenience, it is stored and invoked as is.
+ */
+template <typename... Args>
+class BLECallback {
+ public:
+  using Fn = void (*)(Args... args, void* pArg);
+
+  BLECallback() : _fn(nullptr), _pArg(nullptr), _function() {}
+
+  BLECallback(const BLECallback&) = delete;
+  BLECallback& operator=(const BLECallback&) = delete;
+
+  void set(Fn fn, void* pArg) {
+    _fn = nullptr;
+    _function = nullptr;
+    _pArg = pArg;
+    _fn = fn;
+  }
+
+  void set(const std::function<void(Args...)>& function) {
+    _fn = nullptr;
+    _pArg = nullptr;
+    _function = function;
+  }
+
+  explicit operator bool() const { return _fn != nullptr || _function; }
+
+  void operator()(Args... args) const {
+    if (_fn) {
+      _fn(args..., _pArg);
+    } else if (_function) {
+      _function(args...);
+    }
+  }
+
+ private:
+  Fn _fn;
+  void* _pArg;
+  std::function<void(Args...)> _function;
+};
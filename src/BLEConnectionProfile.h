@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Connection parameters requested from a controller after it connects.
+enum class BLEConnectionProfile : uint8_t {
+  /// @brief Keep the parameters chosen by the controller and the BLE stack.
+  Default = 0,
+  /// @brief 7.5 ms connection interval and no peripheral latency, for the lowest input latency.
+  LowestLatency = 1,
+  /// @brief 15 to 30 ms connection interval and no peripheral latency.
+  Balanced = 2,
+  /// @brief 50 to 100 ms connection interval, the controller may skip up to 4 connection events when idle.
+  BatterySaver = 3,
+  /// @brief `LowestLatency` while the controls change, `BatterySaver` after no change for
+  /// CONFIG_BT_BLEGC_ADAPTIVE_IDLE_TIMEOUT_MS.
+  Adaptive = 4,
+};
+
+struct BLEAdaptiveConnectionStats {
+  /// @brief Time spent connected with the active (low latency) parameters, in milliseconds.
+  uint64_t activeMs{0};
+
+  /// @brief Time spent connected with the idle (battery saving) parameters, in milliseconds.
+  uint64_t idleMs{0};
+
+  /// @brief Number of switches between the active and the idle parameters.
+  uint32_t switches{0};
+};
+
+struct BLEConnectionParams {
+  /// @brief Connection interval, in microseconds.
+  uint32_t intervalUs{0};
+
+  /// @brief Number of connection events the controller may skip when it has no data to send.
+  uint16_t latency{0};
+
+  /// @brief Supervision timeout, in milliseconds.
+  uint32_t supervisionTimeoutMs{0};
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Stages of setting up a connection with a controller, in the order they are reached.
+enum class BLEConnectionStage : uint8_t {
+  /// @brief Controller instance allocated for an advertising device.
+  Allocated = 0,
+  /// @brief Connection requested from the BLE stack.
+  ConnectStarted = 1,
+  /// @brief Link established.
+  Connected = 2,
+  /// @brief Pairing or encryption with the stored bond requested.
+  SecurityStarted = 3,
+  /// @brief Link encrypted and bonded.
+  Authenticated = 4,
+  /// @brief Device information and report map read, or loaded from the cache.
+  HidInitDone = 5,
+  /// @brief Controller specific initialization done, e.g. characteristics found and subscribed to.
+  InitDone = 6,
+  /// @brief Controller marked as connected, right before the connected callback is scheduled.
+  MarkedConnected = 7,
+};
+
+constexpr uint8_t BLEConnectionStageCount = 8;
+
+struct BLEConnectionTimings {
+  /// @brief Time at which each stage was reached, in microseconds since boot, indexed by `BLEConnectionStage`. Stages
+  /// not reached yet during the current connection attempt are 0.
+  int64_t stageUs[BLEConnectionStageCount]{};
+
+  int64_t at(const BLEConnectionStage stage) const { return stageUs[static_cast<uint8_t>(stage)]; }
+};
+
+struct BLEDurationStats {
+  int64_t minUs{0};
+  int64_t avgUs{0};
+  int64_t maxUs{0};
+};
+
+struct BLEConnectionTimingStats {
+  /// @brief Number of connections the stats were computed from.
+  uint32_t connections{0};
+
+  /// @brief Time from allocation until the controller was marked as connected.
+  BLEDurationStats total{};
+
+  /// @brief Time spent reaching each stage from the previous one, indexed by `BLEConnectionStage`. The entry of
+  /// `Allocated` is always 0.
+  BLEDurationStats stages[BLEConnectionStageCount]{};
+};
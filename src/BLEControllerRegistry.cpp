@@ -4,14 +4,21 @@
 #include <NimBLEDevice.h>
 #include <NimBLEScan.h>
 #include <NimBLEUtils.h>
+#include <esp_timer.h>
 #include <bitset>
+#include <cstring>
 #include <memory>
 #include <optional>
 #include "BLEAbstractController.h"
+#include "BLEGamepadClient.h"
 #include "config.h"
 #include "logger.h"
 #include "messages.h"
 
+// index keys are encoded addresses, an allocated controller never has the address 0
+constexpr uint64_t emptyKey = 0;
+constexpr uint64_t erasedKey = UINT64_MAX;
+
 BLEControllerRegistry::ClientEvent::operator std::string() const {
   std::string kindStr;
   // clang-format off
@@ -21,19 +28,26 @@ BLEControllerRegistry::ClientEvent::operator std::string() const {
     case ClientEventKind::ClientDisconnected: kindStr = "BLEClientDisconnected"; break;
     case ClientEventKind::ClientConnectionFailed: kindStr = "BLEClientConnectingFailed"; break;
     case ClientEventKind::ClientBondingFailed: kindStr = "BLEClientBondingFailed"; break;
+    case ClientEventKind::ClientConnParamsUpdated: kindStr = "BLEClientConnParamsUpdated"; break;
   }
   // clang-format on
   return "BLEClientEvent address: " + std::string(address) + ", kind: " + kindStr;
 }
 
 BLEControllerRegistry::BLEControllerRegistry(TaskHandle_t& autoScanTask, QueueHandle_t& userCallbackQueue)
-    : _controllers({}),
-      _controllersMutex(nullptr),
+    : _controllersMutex(nullptr),
       _autoScanTask(autoScanTask),
       _userCallbackQueue(userCallbackQueue),
       _clientEventQueue(nullptr),
       _clientEventConsumerTask(nullptr),
       _clientCallbacksImpl(*this) {
+  for (auto& entry : _index) {
+    _setIndexKey(entry, emptyKey);
+  }
+  for (auto& entry : _affinity) {
+    _setIndexKey(entry, emptyKey);
+  }
+
   _controllersMutex = xSemaphoreCreateMutex();
   configASSERT(_controllersMutex);
 
@@ -59,22 +73,40 @@ BLEControllerRegistry::~BLEControllerRegistry() {
     vSemaphoreDelete(_controllersMutex);
     _controllersMutex = nullptr;
   }
-
-  _controllers.clear();
 }
 
 void BLEControllerRegistry::registerController(BLEAbstractController* pCtrl) {
-
   configASSERT(xSemaphoreTake(_controllersMutex, portMAX_DELAY));
-  for (auto* pSomeCtrl: _controllers) {
+  std::atomic<BLEAbstractController*>* pFreeSlot = nullptr;
+  bool found = false;
+  for (auto& slot : _controllers) {
+    auto* pSomeCtrl = slot.load();
     if (pSomeCtrl == pCtrl) {
-      BLEGC_LOGD("Controller already registered");
+      found = true;
       break;
     }
+    if (!pSomeCtrl && !pFreeSlot) {
+      pFreeSlot = &slot;
+    }
+  }
+  if (!found && pFreeSlot) {
+    pFreeSlot->store(pCtrl, std::memory_order_release);
+    _compileMatcher();
   }
-  _controllers.push_back(pCtrl);
   configASSERT(xSemaphoreGive(_controllersMutex));
 
+  if (found) {
+    BLEGC_LOGD("Controller already registered");
+    return;
+  }
+
+  if (!pFreeSlot) {
+    BLEGC_LOGE("Failed to register controller, all %zu slots are taken", maxControllers);
+    return;
+  }
+
+  _loadAffinity(pCtrl);
+
   BLEGC_LOGD("Controller registered");
   _notifyAutoScan();
 }
@@ -105,16 +137,23 @@ void BLEControllerRegistry::deregisterController(BLEAbstractController* pCtrl, b
 
   configASSERT(xSemaphoreTake(_controllersMutex, portMAX_DELAY));
   bool found = false;
-  for (auto it = _controllers.begin(); it != _controllers.end();) {
-    if (*it == pCtrl) {
-      _controllers.erase(it);
+  for (auto& slot : _controllers) {
+    if (slot.load() == pCtrl) {
+      slot.store(nullptr, std::memory_order_release);
       found = true;
       break;
     }
-    ++it;
+  }
+  if (found) {
+    _compileMatcher();
   }
   configASSERT(xSemaphoreGive(_controllersMutex));
 
+  const auto lastAddress = pCtrl->getLastAddress();
+  if (found && !lastAddress.isNull()) {
+    _indexErase(_affinity, BLEAbstractController::_encodeAddress(lastAddress), pCtrl);
+  }
+
   if (!found) {
     BLEGC_LOGD("Controller not registered");
   }
@@ -128,11 +167,13 @@ void BLEControllerRegistry::deregisterController(BLEAbstractController* pCtrl, b
   BLEGC_LOGD("Controller deregistered");
 }
 
-void BLEControllerRegistry::tryConnectController(const NimBLEAdvertisedDevice* pAdvertisedDevice) {
+// returns true if a connection was initiated, which stops the scan
+bool BLEControllerRegistry::tryConnectController(const NimBLEAdvertisedDevice* pAdvertisedDevice) {
   auto* pCtrl = _findAndAllocateController(pAdvertisedDevice);
   if (!pCtrl) {
-    return;
+    return false;
   }
+  pCtrl->markStage(BLEConnectionStage::Allocated, esp_timer_get_time());
 
   const auto address = pAdvertisedDevice->getAddress();
 
@@ -142,7 +183,7 @@ void BLEControllerRegistry::tryConnectController(const NimBLEAdvertisedDevice* p
   if (!pClient) {
     BLEGC_LOGE("Failed to create client for a device, address: %s", std::string(address).c_str());
     _sendClientEvent({address, ClientEventKind::ClientConnectionFailed});
-    return;
+    return false;
   }
 
   pClient->setSelfDelete(false, false);
@@ -153,94 +194,403 @@ void BLEControllerRegistry::tryConnectController(const NimBLEAdvertisedDevice* p
 
   BLEGC_LOGI("Attempting to connect to a device, address: %s", std::string(pClient->getPeerAddress()).c_str());
 
+  pCtrl->markStage(BLEConnectionStage::ConnectStarted, esp_timer_get_time());
   if (!pClient->connect(true, true, true)) {
     BLEGC_LOGE("Failed to initiate connection, address: %s", std::string(pClient->getPeerAddress()).c_str());
     _sendClientEvent({address, ClientEventKind::ClientConnectionFailed});
-    return;
+    return false;
   }
 
   pCtrl->markConnecting();
   _sendUserCallbackMsg({BLEUserCallbackKind::ScanStopped});  // pClient->connect() implicitly stopped a scan
   _sendUserCallbackMsg({BLEUserCallbackKind::ControllerConnecting, pCtrl});
+  return true;
 }
 BLEControllerRegistry::AllocationInfo BLEControllerRegistry::getAllocationInfo() const {
   AllocationInfo result;
 
-  configASSERT(xSemaphoreTake(_controllersMutex, portMAX_DELAY));
-  for (const auto* pCtrl : _controllers) {
+  for (const auto& slot : _controllers) {
+    const auto* pCtrl = slot.load(std::memory_order_acquire);
+    if (!pCtrl) {
+      continue;
+    }
     if (pCtrl->isAllocated()) {
       result.allocated++;
     } else {
       result.notAllocated++;
     }
   }
-  configASSERT(xSemaphoreGive(_controllersMutex));
 
   return result;
 }
 
-BLEAbstractController* BLEControllerRegistry::_findController(const NimBLEAddress& address) const {
-  BLEAbstractController* result = nullptr;
+/**
+ * @brief Collects the addresses the controllers waiting for a connection were last connected to.
+ * @param[out] addresses Array of at least `CONFIG_BT_BLEGC_MAX_CONTROLLERS` addresses, filled with the addresses.
+ * @param[out] pCount Set to the number of addresses.
+ * @return False if a waiting controller has never been connected, so it may connect to any device.
+ */
+bool BLEControllerRegistry::getReconnectAddresses(NimBLEAddress addresses[], size_t* pCount) const {
+  *pCount = 0;
+  bool allKnown = true;
+
+  // the last addresses are written with the mutex held, so that all of them are read as of the same moment
   configASSERT(xSemaphoreTake(_controllersMutex, portMAX_DELAY));
-  for (auto* pCtrl : _controllers) {
-    if (pCtrl->getAddress() == address) {
-      result = pCtrl;
+  for (const auto& slot : _controllers) {
+    const auto* pCtrl = slot.load(std::memory_order_acquire);
+    if (!pCtrl || pCtrl->isAllocated() || pCtrl->isPendingDeregistration()) {
+      continue;
+    }
+
+    const auto lastAddress = pCtrl->getLastAddress();
+    if (lastAddress.isNull()) {
+      allKnown = false;
       break;
     }
+    addresses[(*pCount)++] = lastAddress;
   }
   configASSERT(xSemaphoreGive(_controllersMutex));
 
-  return result;
+  return allKnown;
+}
+
+BLEAbstractController* BLEControllerRegistry::_findController(const NimBLEAddress& address) const {
+  const auto key = BLEAbstractController::_encodeAddress(address);
+  if (auto* pCtrl = _findInIndex(key)) {
+    return pCtrl;
+  }
+
+  // the index is updated right after allocation, a lookup racing with it finds the controller in the table
+  for (const auto& slot : _controllers) {
+    auto* pCtrl = slot.load(std::memory_order_acquire);
+    if (pCtrl && pCtrl->_address == key) {
+      return pCtrl;
+    }
+  }
+
+  return nullptr;
+}
+
+BLEAbstractController* BLEControllerRegistry::_findInIndex(const uint64_t key) const {
+  return _indexFind(_index, key, true);
+}
+
+BLEAbstractController* BLEControllerRegistry::_indexFind(const IndexEntry index[], const uint64_t key,
+                                                         const bool allocated) {
+  for (size_t i = _indexHash(key), probes = 0; probes < indexSize; i = (i + 1) & (indexSize - 1), probes++) {
+    const auto entryKey = _indexKey(index[i]);
+    if (entryKey == emptyKey) {
+      break;
+    }
+    if (entryKey != key) {
+      continue;
+    }
+
+    // an entry may be reused while it is read, the controller's own address is authoritative
+    auto* pCtrl = index[i].pCtrl.load(std::memory_order_acquire);
+    if (pCtrl && (!allocated || pCtrl->_address == key)) {
+      return pCtrl;
+    }
+  }
+
+  return nullptr;
 }
 
 BLEAbstractController* BLEControllerRegistry::_findAndAllocateController(
     const NimBLEAdvertisedDevice* pAdvertisedDevice) {
   const auto address = pAdvertisedDevice->getAddress();
 
-  std::vector<BLEAbstractController*> suitableControllers;
+  // the device is already being connected or connected
+  if (_findInIndex(BLEAbstractController::_encodeAddress(address))) {
+    return nullptr;
+  }
 
-  configASSERT(xSemaphoreTake(_controllersMutex, portMAX_DELAY));
-  for (auto* pCtrl : _controllers) {
-    if (pCtrl->isAllocated() || !pCtrl->isSupported(pAdvertisedDevice) || pCtrl->isPendingDeregistration()) {
+  const auto match = _matcher.classify(pAdvertisedDevice);
+  if (match.slots == 0) {
+    return nullptr;
+  }
+
+  // a known device goes straight to the controller it was connected to last time, also after a reboot
+  auto* pPreferredCtrl = _indexFind(_affinity, BLEAbstractController::_encodeAddress(address), false);
+  const auto preferredSlot = pPreferredCtrl ? _slotOf(pPreferredCtrl) : maxControllers;
+  if (preferredSlot < maxControllers && match.slots & 1u << preferredSlot && !pPreferredCtrl->isAllocated() &&
+      !pPreferredCtrl->isPendingDeregistration() && pPreferredCtrl->getLastAddress() == address &&
+      _allocate(pPreferredCtrl, address)) {
+    return pPreferredCtrl;
+  }
+
+  BLEAbstractController* suitableControllers[maxControllers];
+  size_t suitableCount = 0;
+
+  for (size_t i = 0; i < maxControllers; i++) {
+    if (!(match.slots & 1u << i)) {
+      continue;
+    }
+    auto* pCtrl = _controllers[i].load(std::memory_order_acquire);
+    if (!pCtrl || pCtrl->isAllocated() || pCtrl->isPendingDeregistration()) {
       continue;
     }
-    suitableControllers.push_back(pCtrl);
+    suitableControllers[suitableCount++] = pCtrl;
   }
-  configASSERT(xSemaphoreGive(_controllersMutex));
 
   // allocate ctrl allocated last time
-  for (auto* pCtrl : suitableControllers) {
+  for (size_t i = 0; i < suitableCount; i++) {
+    auto* pCtrl = suitableControllers[i];
     if (!pCtrl->getLastAddress().isNull() && pCtrl->getLastAddress() == address) {
-      if (pCtrl->tryAllocate(address)) {
+      if (_allocate(pCtrl, address)) {
         return pCtrl;
       }
     }
   }
 
   // allocate ctrl never allocated
-  for (auto* pCtrl : suitableControllers) {
+  for (size_t i = 0; i < suitableCount; i++) {
+    auto* pCtrl = suitableControllers[i];
     if (pCtrl->getLastAddress().isNull()) {
-      if (pCtrl->tryAllocate(address)) {
+      if (_allocate(pCtrl, address)) {
         return pCtrl;
       }
     }
   }
 
   // allocate any other controller (don't try to allocate controllers already tried)
-  for (auto* pCtrl : suitableControllers) {
+  for (size_t i = 0; i < suitableCount; i++) {
+    auto* pCtrl = suitableControllers[i];
     if (!pCtrl->getLastAddress().isNull() && pCtrl->getLastAddress() != address) {
-      if (pCtrl->tryAllocate(address)) {
+      if (_allocate(pCtrl, address)) {
         return pCtrl;
       }
     }
   }
 
-  BLEGC_LOGD("No suitable controller found to allocate for a device, address %s", std::string(address).c_str());
+  if (BLEGC_LOG_ENABLED(ESP_LOG_DEBUG)) {
+    BLEGC_LOGD("No suitable controller found to allocate for a device, address %s", std::string(address).c_str());
+  }
   return nullptr;
 }
 
+bool BLEControllerRegistry::_allocate(BLEAbstractController* pCtrl, const NimBLEAddress& address) {
+  if (!pCtrl->tryAllocate(address)) {
+    return false;
+  }
+
+  _indexInsert(_index, BLEAbstractController::_encodeAddress(address), pCtrl);
+  return true;
+}
+
+bool BLEControllerRegistry::_deallocate(BLEAbstractController* pCtrl) {
+  const auto key = pCtrl->_address.load();
+  const auto lastAddress = pCtrl->getLastAddress();
+  if (!pCtrl->tryDeallocate()) {
+    return false;
+  }
+
+  _indexErase(_index, key, pCtrl);
+  _setLastAddress(pCtrl, BLEAbstractController::_decodeAddress(key));
+
+  // the controller prefers the address it was just allocated to
+  if (!lastAddress.isNull()) {
+    _indexErase(_affinity, BLEAbstractController::_encodeAddress(lastAddress), pCtrl);
+  }
+  _indexInsert(_affinity, key, pCtrl);
+  return true;
+}
+
+// returns maxControllers if the controller is not registered
+size_t BLEControllerRegistry::_slotOf(const BLEAbstractController* pCtrl) const {
+  size_t slot = 0;
+  while (slot < maxControllers && _controllers[slot].load(std::memory_order_acquire) != pCtrl) {
+    slot++;
+  }
+  return slot;
+}
+
+// Affinity layout: encoded address of the controller last connected to the n-th registered instance of a controller
+// type, 8 bytes little-endian. The type is identified by a hash of its match rules, so an instance of another type
+// registered in the same order after a reboot doesn't take the address over.
+static uint32_t matchRulesHash(const BLEAdvMatchRules& rules) {
+  // FNV-1a over the rule contents, the rules array itself may move between builds
+  uint32_t hash = 2166136261u;
+  const auto mix = [&hash](const uint32_t value) {
+    for (size_t i = 0; i < sizeof(value); i++) {
+      hash = (hash ^ (value >> (8 * i) & 0xff)) * 16777619u;
+    }
+  };
+  for (size_t i = 0; i < rules.count; i++) {
+    const auto& rule = rules.pRules[i];
+    mix(rule.fields);
+    for (const char* pName = rule.name; pName && *pName; pName++) {
+      mix(static_cast<uint8_t>(*pName));
+    }
+    mix(rule.appearance);
+    mix(rule.companyId);
+    mix(rule.serviceUUID);
+  }
+  return hash;
+}
+
+// returns false if the controller is not registered
+bool BLEControllerRegistry::_affinityKey(char (&key)[16], const BLEAbstractController* pCtrl) const {
+  const auto rules = pCtrl->getMatchRules();
+  size_t typeIndex = 0;
+  for (const auto& slot : _controllers) {
+    const auto* pOther = slot.load(std::memory_order_acquire);
+    if (pOther == pCtrl) {
+      snprintf(key, sizeof(key), "a%08x%u", static_cast<unsigned int>(matchRulesHash(rules)),
+               static_cast<unsigned int>(typeIndex));
+      return true;
+    }
+    if (pOther && pOther->getMatchRules().pRules == rules.pRules) {
+      typeIndex++;
+    }
+  }
+  return false;
+}
+
+void BLEControllerRegistry::_loadAffinity(BLEAbstractController* pCtrl) {
+  // a controller registered again keeps the address it was connected to during this session, its storage key may have
+  // changed with the registration order, so the address is stored again on the next connection
+  const auto lastAddress = pCtrl->getLastAddress();
+  if (!lastAddress.isNull()) {
+    pCtrl->_storedAddress = 0;
+    _indexInsert(_affinity, BLEAbstractController::_encodeAddress(lastAddress), pCtrl);
+    return;
+  }
+
+  auto* pStorage = BLEGamepadClient::getStorage();
+  char key[16];
+  if (!pStorage || !_affinityKey(key, pCtrl)) {
+    return;
+  }
+
+  uint8_t data[sizeof(uint64_t)];
+  if (pStorage->read(key, data, sizeof(data)) != sizeof(data)) {
+    return;
+  }
+
+  uint64_t address = 0;
+  for (size_t i = sizeof(data); i-- > 0;) {
+    address = address << 8 | data[i];
+  }
+  if (address == 0) {
+    return;
+  }
+
+  const auto preferredAddress = BLEAbstractController::_decodeAddress(address);
+  pCtrl->_storedAddress = address;
+  _setLastAddress(pCtrl, preferredAddress);
+  _indexInsert(_affinity, address, pCtrl);
+  BLEGC_LOGD("Controller %s prefers address %s", key, std::string(preferredAddress).c_str());
+}
+
+void BLEControllerRegistry::_setLastAddress(BLEAbstractController* pCtrl, const NimBLEAddress& address) {
+  configASSERT(xSemaphoreTake(_controllersMutex, portMAX_DELAY));
+  pCtrl->_lastAddress.beginWrite() = address;
+  pCtrl->_lastAddress.endWrite();
+  configASSERT(xSemaphoreGive(_controllersMutex));
+}
+
+void BLEControllerRegistry::_storeAffinity(BLEAbstractController* pCtrl) const {
+  // avoid wearing the flash when the same controller reconnects, compared with the address in the storage rather than
+  // the last address, which is also set by failed connections
+  const uint64_t address = pCtrl->_address;
+  if (pCtrl->_storedAddress == address) {
+    return;
+  }
+
+  auto* pStorage = BLEGamepadClient::getStorage();
+  char key[16];
+  if (!pStorage || !_affinityKey(key, pCtrl)) {
+    return;
+  }
+
+  uint8_t data[sizeof(uint64_t)];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = address >> (8 * i);
+  }
+  if (!pStorage->write(key, data, sizeof(data))) {
+    BLEGC_LOGW("Failed to store the preferred address of controller %s", key);
+    return;
+  }
+  pCtrl->_storedAddress = address;
+}
+
+void BLEControllerRegistry::_indexInsert(IndexEntry index[], const uint64_t key, BLEAbstractController* pCtrl) {
+  configASSERT(xSemaphoreTake(_controllersMutex, portMAX_DELAY));
+  IndexEntry* pFree = nullptr;
+  for (size_t i = _indexHash(key), probes = 0; probes < indexSize; i = (i + 1) & (indexSize - 1), probes++) {
+    auto& entry = index[i];
+    const auto entryKey = _indexKey(entry);
+    if (entryKey == key) {
+      pFree = &entry;
+      break;
+    }
+    if (entryKey == erasedKey && !pFree) {
+      pFree = &entry;
+    }
+    if (entryKey == emptyKey) {
+      pFree = pFree ? pFree : &entry;
+      break;
+    }
+  }
+
+  // the table holds twice as many entries as there are controllers, so there is always a free one
+  configASSERT(pFree);
+  pFree->pCtrl.store(pCtrl, std::memory_order_release);
+  _setIndexKey(*pFree, key);
+  configASSERT(xSemaphoreGive(_controllersMutex));
+}
+
+void BLEControllerRegistry::_indexErase(IndexEntry index[], const uint64_t key, const BLEAbstractController* pCtrl) {
+  configASSERT(xSemaphoreTake(_controllersMutex, portMAX_DELAY));
+  for (size_t i = _indexHash(key), probes = 0; probes < indexSize; i = (i + 1) & (indexSize - 1), probes++) {
+    auto& entry = index[i];
+    const auto entryKey = _indexKey(entry);
+    if (entryKey == emptyKey) {
+      break;
+    }
+    if (entryKey == key && entry.pCtrl.load() == pCtrl) {
+      // probe sequences of other keys may pass through this entry, so it is marked as erased instead of emptied
+      _setIndexKey(entry, erasedKey);
+      entry.pCtrl.store(nullptr, std::memory_order_release);
+      break;
+    }
+  }
+  configASSERT(xSemaphoreGive(_controllersMutex));
+}
+
+// must be called with the mutex held
+void BLEControllerRegistry::_compileMatcher() {
+  BLEAdvMatchRules rulesBySlot[maxControllers];
+  for (size_t i = 0; i < maxControllers; i++) {
+    const auto* pCtrl = _controllers[i].load();
+    rulesBySlot[i] = pCtrl ? pCtrl->getMatchRules() : BLEAdvMatchRules{nullptr, 0};
+  }
+
+  _matcher.compile(rulesBySlot, maxControllers);
+}
+
+size_t BLEControllerRegistry::_indexHash(const uint64_t key) {
+  // Fibonacci hashing mixes all bits of the address and the address type into the index
+  return static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> 32) & (indexSize - 1);
+}
+
+uint64_t BLEControllerRegistry::_indexKey(const IndexEntry& entry) {
+  uint64_t key;
+  entry.key.read(&key);
+  return key;
+}
+
+// must be called with the mutex held, the snapshot allows a single writer only
+void BLEControllerRegistry::_setIndexKey(IndexEntry& entry, const uint64_t key) {
+  entry.key.beginWrite() = key;
+  entry.key.endWrite();
+}
+
 void BLEControllerRegistry::_sendClientEvent(const ClientEvent& msg) const {
-  if (xQueueSend(_clientEventQueue, &msg, 0) != pdPASS) {
+  auto timestampedMsg = msg;
+  timestampedMsg.timestampUs = esp_timer_get_time();
+  if (xQueueSend(_clientEventQueue, &timestampedMsg, 0) != pdPASS) {
     BLEGC_LOGE("Failed to send client event message");
   }
 }
@@ -275,6 +625,8 @@ void BLEControllerRegistry::_clientEventConsumerFn(void* pvParameters) {
 
     switch (msg.kind) {
       case ClientEventKind::ClientConnected: {
+        pCtrl->markStage(BLEConnectionStage::Connected, msg.timestampUs);
+        pCtrl->markStage(BLEConnectionStage::SecurityStarted, esp_timer_get_time());
         if (!pCtrl->getClient()->secureConnection(true)) {  // async = true
           BLEGC_LOGE("Failed to initiate secure connection, address: %s", std::string(msg.address).c_str());
           pCtrl->getClient()->disconnect();
@@ -282,6 +634,7 @@ void BLEControllerRegistry::_clientEventConsumerFn(void* pvParameters) {
         break;
       }
       case ClientEventKind::ClientBonded: {
+        pCtrl->markStage(BLEConnectionStage::Authenticated, msg.timestampUs);
         if (pCtrl->isPendingDeregistration()) {
           pCtrl->getClient()->disconnect();
           break;
@@ -289,6 +642,8 @@ void BLEControllerRegistry::_clientEventConsumerFn(void* pvParameters) {
 
         auto retryCount = 2;
         while (!(pCtrl->hidInit() && pCtrl->init()) && --retryCount) {
+          // cached attributes may be stale, read them from the controller on the next attempt
+          pCtrl->invalidateCache();
         }
 
         if (retryCount == 0) {
@@ -297,7 +652,12 @@ void BLEControllerRegistry::_clientEventConsumerFn(void* pvParameters) {
           break;
         }
 
+        pCtrl->markStage(BLEConnectionStage::InitDone, esp_timer_get_time());
         pCtrl->markConnected();
+        self->_storeAffinity(pCtrl);
+        if (!pCtrl->applyConnectionProfile()) {
+          BLEGC_LOGW("Failed to request connection parameters, address: %s", std::string(msg.address).c_str());
+        }
         self->_sendUserCallbackMsg({BLEUserCallbackKind::ControllerConnected, pCtrl});
 
         BLEGC_LOGD("Controller successfully initialized");
@@ -309,7 +669,7 @@ void BLEControllerRegistry::_clientEventConsumerFn(void* pvParameters) {
           BLEGC_LOGW("Failed to deinitialize controller, address: %s", std::string(msg.address).c_str());
         }
 
-        if (!pCtrl->tryDeallocate()) {
+        if (!self->_deallocate(pCtrl)) {
           BLEGC_LOGE("Failed to deallocate controller %s", std::string(msg.address).c_str());
           break;
         }
@@ -336,7 +696,7 @@ void BLEControllerRegistry::_clientEventConsumerFn(void* pvParameters) {
         break;
       }
       case ClientEventKind::ClientConnectionFailed: {
-        if (!pCtrl->tryDeallocate()) {
+        if (!self->_deallocate(pCtrl)) {
           BLEGC_LOGE("Failed to deallocate controller %s", std::string(msg.address).c_str());
           break;
         }
@@ -363,6 +723,10 @@ void BLEControllerRegistry::_clientEventConsumerFn(void* pvParameters) {
         pCtrl->getClient()->disconnect();
         break;
       }
+      case ClientEventKind::ClientConnParamsUpdated: {
+        pCtrl->onConnParamsUpdated();
+        break;
+      }
     }
   }
 }
@@ -391,6 +755,14 @@ void BLEControllerRegistry::ClientCallbacksImpl::onAuthenticationComplete(NimBLE
   }
 }
 
+void BLEControllerRegistry::ClientCallbacksImpl::onConnParamsUpdate(NimBLEClient* pClient) {
+  const auto connInfo = pClient->getConnInfo();
+  BLEGC_LOGD("Connection parameters updated, address: %s, interval: %d, latency: %d, timeout: %d",
+             std::string(pClient->getPeerAddress()).c_str(), connInfo.getConnInterval(), connInfo.getConnLatency(),
+             connInfo.getConnTimeout());
+  _controllerRegistry._sendClientEvent({pClient->getPeerAddress(), ClientEventKind::ClientConnParamsUpdated});
+}
+
 void BLEControllerRegistry::ClientCallbacksImpl::onDisconnect(NimBLEClient* pClient, int reason) {
   BLEGC_LOGI("Device disconnected, address: %s, reason: 0x%04x %s", std::string(pClient->getPeerAddress()).c_str(),
              reason, NimBLEUtils::returnCodeToString(reason));
@@ -4,8 +4,20 @@
 #include <atomic>
 #include <memory>
 #include "BLEAbstractController.h"
+#include "BLEAdvMatcher.h"
+#include "BLEValueSnapshot.h"
+#include "config.h"
 #include "messages.h"
 
+// smallest power of two that keeps the address index at most half full
+static constexpr size_t registryIndexSize(const size_t maxControllers) {
+  size_t size = 2;
+  while (size < 2 * maxControllers) {
+    size <<= 1;
+  }
+  return size;
+}
+
 class BLEControllerRegistry {
  public:
   struct AllocationInfo {
@@ -18,8 +30,9 @@ class BLEControllerRegistry {
 
   void registerController(BLEAbstractController* pCtrl);
   void deregisterController(BLEAbstractController* pCtrl, bool notifyAutoScan = false);
-  void tryConnectController(const NimBLEAdvertisedDevice* pAdvertisedDevice);
+  bool tryConnectController(const NimBLEAdvertisedDevice* pAdvertisedDevice);
   AllocationInfo getAllocationInfo() const;
+  bool getReconnectAddresses(NimBLEAddress addresses[], size_t* pCount) const;
 
  private:
   class ClientCallbacksImpl final : public NimBLEClientCallbacks {
@@ -29,6 +42,7 @@ class BLEControllerRegistry {
     void onConnectFail(NimBLEClient* pClient, int reason) override;
     void onAuthenticationComplete(NimBLEConnInfo& connInfo) override;
     void onDisconnect(NimBLEClient* pClient, int reason) override;
+    void onConnParamsUpdate(NimBLEClient* pClient) override;
     BLEControllerRegistry& _controllerRegistry;
   };
 
@@ -38,17 +52,46 @@ class BLEControllerRegistry {
     ClientConnected = 0,
     ClientBonded = 1,
     ClientDisconnected = 2,
+    ClientConnParamsUpdated = 5,
   };
 
   struct ClientEvent {
     NimBLEAddress address;
     ClientEventKind kind;
+    int64_t timestampUs{0};
 
     explicit operator std::string() const;
   };
 
+  // 64-bit atomics are not lock-free on 32-bit targets, so the keys probed for every advertisement are read through a
+  // sequence lock. The atomic address of a controller is read only to confirm an entry whose key matched.
+  struct IndexEntry {
+    BLEValueSnapshot<uint64_t> key;
+    std::atomic<BLEAbstractController*> pCtrl{nullptr};
+  };
+  static_assert(std::atomic<BLEAbstractController*>::is_always_lock_free, "Index entries are read without a lock");
+
+  static constexpr size_t maxControllers = CONFIG_BT_BLEGC_MAX_CONTROLLERS;
+  static constexpr size_t indexSize = registryIndexSize(maxControllers);
+  static_assert(maxControllers <= BLEAdvMatcher::maxSlots, "Too many controllers for the advertisement matcher");
+
   BLEAbstractController* _findController(const NimBLEAddress& address) const;
+  BLEAbstractController* _findInIndex(uint64_t key) const;
+  static BLEAbstractController* _indexFind(const IndexEntry index[], uint64_t key, bool allocated);
   BLEAbstractController* _findAndAllocateController(const NimBLEAdvertisedDevice* pAdvertisedDevice);
+  bool _allocate(BLEAbstractController* pCtrl, const NimBLEAddress& address);
+  bool _deallocate(BLEAbstractController* pCtrl);
+  void _indexInsert(IndexEntry index[], uint64_t key, BLEAbstractController* pCtrl);
+  void _indexErase(IndexEntry index[], uint64_t key, const BLEAbstractController* pCtrl);
+  size_t _slotOf(const BLEAbstractController* pCtrl) const;
+  bool _affinityKey(char (&key)[16], const BLEAbstractController* pCtrl) const;
+  void _loadAffinity(BLEAbstractController* pCtrl);
+  void _setLastAddress(BLEAbstractController* pCtrl, const NimBLEAddress& address);
+  void _storeAffinity(BLEAbstractController* pCtrl) const;
+  static size_t _indexHash(uint64_t key);
+  static uint64_t _indexKey(const IndexEntry& entry);
+  static void _setIndexKey(IndexEntry& entry, uint64_t key);
+  void _compileMatcher();
   void _sendClientEvent(const ClientEvent& msg) const;
   void _sendUserCallbackMsg(const BLEAbstractController* pCtrl) const;
   void _startScan() const;
@@ -56,7 +99,14 @@ class BLEControllerRegistry {
   void _sendUserCallbackMsg(const BLEUserCallback& msg) const;
   static void _clientEventConsumerFn(void* pvParameters);
 
-  std::vector<BLEAbstractController*> _controllers;
+  // written only with the mutex held, read without it
+  std::atomic<BLEAbstractController*> _controllers[maxControllers]{};
+  // allocated controllers by their address, written with the mutex held only when a controller is allocated or
+  // released, looked up for every advertisement without it
+  IndexEntry _index[indexSize];
+  // controllers by the address they were last connected to
+  IndexEntry _affinity[indexSize];
+  BLEAdvMatcher _matcher;
   SemaphoreHandle_t _controllersMutex;
   TaskHandle_t& _autoScanTask;
   QueueHandle_t& _userCallbackQueue;
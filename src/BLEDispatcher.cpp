@@ -0,0 +1,66 @@
+#include "BLEDispatcher.h"
+
+#include <NimBLEDevice.h>
+#include "config.h"
+#include "logger.h"
+
+BLEDispatcher::BLEDispatcher() : _workQueue(nullptr), _dispatcherTask(nullptr) {
+  _workQueue = xQueueCreate(CONFIG_BT_BLEGC_DISPATCHER_QUEUE_LENGTH, sizeof(WorkItem));
+  configASSERT(_workQueue);
+
+  xTaskCreate(_dispatcherTaskFn, "_dispatcherTask", CONFIG_BT_BLEGC_DISPATCHER_STACK_SIZE, this, 0,
+              &_dispatcherTask);
+  configASSERT(_dispatcherTask);
+}
+
+BLEDispatcher::~BLEDispatcher() {
+  if (_dispatcherTask != nullptr) {
+    vTaskDelete(_dispatcherTask);
+    _dispatcherTask = nullptr;
+  }
+  if (_workQueue != nullptr) {
+    vQueueDelete(_workQueue);
+    _workQueue = nullptr;
+  }
+}
+
+/**
+ * @brief Creates the dispatcher task, if not created yet.
+ */
+void BLEDispatcher::init() {
+  _getInstance();
+}
+
+/**
+ * @brief Queues the work to be run on the dispatcher task. Does not block.
+ * @param fn Function to run.
+ * @param pArg Argument passed to the function.
+ * @return True if the work was queued, false if the queue is full.
+ */
+bool BLEDispatcher::post(const WorkFn fn, void* pArg) {
+  const WorkItem item{fn, pArg};
+  if (xQueueSend(_getInstance()._workQueue, &item, 0) != pdPASS) {
+    BLEGC_LOGE("Failed to send work item to the dispatcher");
+    return false;
+  }
+  return true;
+}
+
+BLEDispatcher& BLEDispatcher::_getInstance() {
+  static BLEDispatcher instance;
+  return instance;
+}
+
+void BLEDispatcher::_dispatcherTaskFn(void* pvParameters) {
+  auto* self = static_cast<BLEDispatcher*>(pvParameters);
+
+  while (true) {
+    WorkItem item{};
+    if (xQueueReceive(self->_workQueue, &item, portMAX_DELAY) != pdTRUE) {
+      BLEGC_LOGE("Failed to receive work item");
+      return;
+    }
+
+    item.fn(item.pArg);
+  }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <NimBLEDevice.h>
+
+/**
+ * @brief Runs deferred work, such as value changed callbacks and writes to controllers, on a single shared task. The
+ * task and its queue are created on first use.
+ */
+class BLEDispatcher {
+ public:
+  using WorkFn = void (*)(void* pArg);
+
+  BLEDispatcher(const BLEDispatcher&) = delete;
+  BLEDispatcher& operator=(const BLEDispatcher&) = delete;
+
+  static void init();
+  static bool post(WorkFn fn, void* pArg);
+
+ private:
+  struct WorkItem {
+    WorkFn fn;
+    void* pArg;
+  };
+
+  BLEDispatcher();
+  ~BLEDispatcher();
+
+  static BLEDispatcher& _getInstance();
+  static void _dispatcherTaskFn(void* pvParameters);
+
+  QueueHandle_t _workQueue;
+  TaskHandle_t _dispatcherTask;
+};
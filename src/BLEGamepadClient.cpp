@@ -8,6 +8,7 @@
 #include "config.h"
 
 bool BLEGamepadClient::_initialized = false;
+BLEStorage* BLEGamepadClient::_pStorage = nullptr;
 TaskHandle_t BLEGamepadClient::_autoScanTask;
 QueueHandle_t BLEGamepadClient::_userCallbackQueue;
 BLEControllerRegistry BLEGamepadClient::_controllerRegistry(_autoScanTask, _userCallbackQueue);
@@ -52,6 +53,23 @@ BLEAutoScan* BLEGamepadClient::getAutoScan() {
   return &_autoScan;
 }
 
+/**
+ * @brief Sets the storage used to cache the attributes of connected controllers between sessions, such as the device
+ * information and the HID report map. Reconnecting to a cached controller skips reading them. The storage also keeps
+ * the address each controller instance was last connected to, so that after a reboot a device reconnects to the same
+ * instance, given that the instances of each controller type are initialized with `begin()` in the same order. Caching
+ * is disabled by default.
+ * @param pStorage Pointer to the storage, e.g. a `BLEPreferencesStorage`, or `nullptr` to disable caching. Must be set
+ * before `begin()` is called on any controller instance and stay valid while set.
+ */
+void BLEGamepadClient::setStorage(BLEStorage* pStorage) {
+  _pStorage = pStorage;
+}
+
+BLEStorage* BLEGamepadClient::getStorage() {
+  return _pStorage;
+}
+
 void BLEGamepadClient::_initSelf() {
   if (!_initialized) {
     blegc::setDefaultLogLevel();
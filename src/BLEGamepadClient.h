@@ -2,11 +2,14 @@
 
 #include "BLEAutoScan.h"
 #include "BLEControllerRegistry.h"
+#include "BLEStorage.h"
 #include "BLEUserCallbackRunner.h"
 
 // export headers
+#include "BLEPreferencesStorage.h"
 #include "xbox/XboxController.h"
 #include "steam/SteamController.h"
+#include "hid/HIDGamepadController.h"
 
 class BLEGamepadClient {
  public:
@@ -15,12 +18,15 @@ class BLEGamepadClient {
   static void init(bool deleteBonds = true);
   static void enableDebugLog();
   static BLEAutoScan* getAutoScan();
+  static void setStorage(BLEStorage* pStorage);
+  static BLEStorage* getStorage();
 
   friend class BLEAbstractController;
 
  private:
   static void _initSelf();
   static bool _initialized;
+  static BLEStorage* _pStorage;
   static TaskHandle_t _autoScanTask;
   static QueueHandle_t _userCallbackQueue;
   static BLEAutoScan _autoScan;
@@ -0,0 +1,53 @@
+#include "BLEPreferencesStorage.h"
+
+#include <Preferences.h>
+#include "logger.h"
+
+/**
+ * @brief Creates the storage.
+ * @param name Name of the NVS namespace to keep the values in, at most 15 characters long. Must stay valid for the
+ * lifetime of the storage.
+ */
+BLEPreferencesStorage::BLEPreferencesStorage(const char* name) : _name(name), _preferences() {}
+
+size_t BLEPreferencesStorage::length(const char* key) {
+  if (!_preferences.begin(_name, true)) {
+    return 0;
+  }
+
+  const auto len = _preferences.isKey(key) ? _preferences.getBytesLength(key) : 0;
+  _preferences.end();
+  return len;
+}
+
+size_t BLEPreferencesStorage::read(const char* key, uint8_t buffer[], const size_t bufferLen) {
+  if (!_preferences.begin(_name, true)) {
+    return 0;
+  }
+
+  const auto len = _preferences.isKey(key) ? _preferences.getBytes(key, buffer, bufferLen) : 0;
+  _preferences.end();
+  return len;
+}
+
+bool BLEPreferencesStorage::write(const char* key, const uint8_t data[], const size_t dataLen) {
+  if (!_preferences.begin(_name, false)) {
+    BLEGC_LOGE("Failed to open the storage, name: %s", _name);
+    return false;
+  }
+
+  const auto written = _preferences.putBytes(key, data, dataLen);
+  _preferences.end();
+  return written == dataLen;
+}
+
+bool BLEPreferencesStorage::remove(const char* key) {
+  if (!_preferences.begin(_name, false)) {
+    BLEGC_LOGE("Failed to open the storage, name: %s", _name);
+    return false;
+  }
+
+  const auto removed = !_preferences.isKey(key) || _preferences.remove(key);
+  _preferences.end();
+  return removed;
+}
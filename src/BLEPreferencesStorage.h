@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Preferences.h>
+#include "BLEStorage.h"
+
+/**
+ * @brief Storage backed by the non-volatile storage (NVS) of the board, through the Arduino Preferences library.
+ */
+class BLEPreferencesStorage final : public BLEStorage {
+ public:
+  explicit BLEPreferencesStorage(const char* name = "blegc");
+  ~BLEPreferencesStorage() override = default;
+
+  size_t length(const char* key) override;
+  size_t read(const char* key, uint8_t buffer[], size_t bufferLen) override;
+  bool write(const char* key, const uint8_t data[], size_t dataLen) override;
+  bool remove(const char* key) override;
+
+ private:
+  const char* _name;
+  Preferences _preferences;
+};
@@ -0,0 +1,139 @@
+#include "BLEReportCapture.h"
+
+#include <NimBLEDevice.h>
+#include "logger.h"
+
+std::atomic_bool BLEReportCapture::_active(false);
+SemaphoreHandle_t BLEReportCapture::_mutex(nullptr);
+uint8_t* BLEReportCapture::_pBuffer(nullptr);
+size_t BLEReportCapture::_capacity(0);
+size_t BLEReportCapture::_head(0);
+size_t BLEReportCapture::_count(0);
+uint32_t BLEReportCapture::_dropped(0);
+
+/**
+ * @brief Starts capturing the notifications of all value receivers. Discards any previously captured data.
+ * @param buffer Storage for the capture. Must stay valid until the capture is stopped.
+ * @param capacity Size of the storage, in bytes.
+ */
+void BLEReportCapture::start(uint8_t buffer[], const size_t capacity) {
+  if (_mutex == nullptr) {
+    _mutex = xSemaphoreCreateMutex();
+    configASSERT(_mutex);
+  }
+
+  configASSERT(xSemaphoreTake(_mutex, portMAX_DELAY));
+  _pBuffer = buffer;
+  _capacity = buffer ? capacity : 0;
+  _head = 0;
+  _count = 0;
+  _dropped = 0;
+  configASSERT(xSemaphoreGive(_mutex));
+
+  _active = _capacity > 0;
+}
+
+/**
+ * @brief Stops capturing. Waits for a record being appended, so the buffer is no longer written once this returns. Data
+ * captured so far can still be read, until the buffer is released by the caller.
+ */
+void BLEReportCapture::stop() {
+  if (_mutex == nullptr) {
+    return;
+  }
+
+  configASSERT(xSemaphoreTake(_mutex, portMAX_DELAY));
+  _active = false;
+  configASSERT(xSemaphoreGive(_mutex));
+}
+
+/**
+ * @brief Moves whole records, oldest first, out of the capture, e.g. to write them to a serial port or a file.
+ * @param[out] out Buffer where the records will be written.
+ * @param maxLen Size of the buffer. Records that do not fit entirely are left in the capture.
+ * @param[out] pDropped Optional, number of records dropped since the previous read because the capture was full.
+ * @return Number of bytes written.
+ */
+size_t BLEReportCapture::read(uint8_t out[], const size_t maxLen, uint32_t* pDropped) {
+  if (_mutex == nullptr) {
+    if (pDropped) {
+      *pDropped = 0;
+    }
+    return 0;
+  }
+
+  configASSERT(xSemaphoreTake(_mutex, portMAX_DELAY));
+  size_t len = 0;
+  while (len + recordHeaderLen <= _count) {
+    const auto recordLen = recordHeaderLen + _peek(len + recordHeaderLen - 1);
+    if (len + recordLen > maxLen) {
+      break;
+    }
+    len += recordLen;
+  }
+
+  const auto tail = (_head + _capacity - _count) % (_capacity > 0 ? _capacity : 1);
+  for (size_t i = 0; i < len; i++) {
+    out[i] = _pBuffer[(tail + i) % _capacity];
+  }
+  _count -= len;
+
+  if (pDropped) {
+    *pDropped = _dropped;
+    _dropped = 0;
+  }
+  configASSERT(xSemaphoreGive(_mutex));
+
+  return len;
+}
+
+/**
+ * @brief Appends a record to the capture. Called from the notification handler, never blocks: the record is dropped
+ * if the capture is full or is being read at the moment.
+ * @param handle Handle of the characteristic that sent the report.
+ * @param data Report data.
+ * @param dataLen Length of the report data.
+ * @param timestampUs Time at which the report was received, in microseconds since boot.
+ */
+void BLEReportCapture::record(const uint16_t handle,
+                              const uint8_t data[],
+                              const size_t dataLen,
+                              const int64_t timestampUs) {
+  if (xSemaphoreTake(_mutex, 0) != pdTRUE) {
+    _dropped++;  // read() resets it under the mutex, a lost increment only affects the statistics
+    return;
+  }
+
+  // the capture was stopped after the caller checked it
+  if (!_active) {
+    configASSERT(xSemaphoreGive(_mutex));
+    return;
+  }
+
+  const auto recordLen = recordHeaderLen + dataLen;
+  if (dataLen > UINT8_MAX || _count + recordLen > _capacity) {
+    _dropped++;
+    configASSERT(xSemaphoreGive(_mutex));
+    return;
+  }
+
+  const auto timestamp = static_cast<uint32_t>(timestampUs);
+  const uint8_t header[recordHeaderLen] = {
+      static_cast<uint8_t>(timestamp),      static_cast<uint8_t>(timestamp >> 8),
+      static_cast<uint8_t>(timestamp >> 16), static_cast<uint8_t>(timestamp >> 24),
+      static_cast<uint8_t>(handle),         static_cast<uint8_t>(handle >> 8),
+      static_cast<uint8_t>(dataLen),
+  };
+
+  for (size_t i = 0; i < recordLen; i++) {
+    _pBuffer[_head] = i < recordHeaderLen ? header[i] : data[i - recordHeaderLen];
+    _head = (_head + 1) % _capacity;
+  }
+  _count += recordLen;
+  configASSERT(xSemaphoreGive(_mutex));
+}
+
+size_t BLEReportCapture::_peek(const size_t offset) {
+  const auto tail = (_head + _capacity - _count) % _capacity;
+  return _pBuffer[(tail + offset) % _capacity];
+}
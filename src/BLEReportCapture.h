@@ -0,0 +1,116 @@
+#pragma once
+
+#include <NimBLEDevice.h>
+#include <esp_timer.h>
+#include <atomic>
+#include "BLEValueReceiver.h"
+#include "logger.h"
+
+/**
+ * @brief Records the raw notifications received by all value receivers into a RAM ring, and replays recorded sessions
+ * through a value receiver.
+ *
+ * The capture is a stream of records, each laid out as follows, multi-byte fields in little-endian order:
+ * - `uint32_t` lower 32 bits of the time at which the report was received, in microseconds since boot,
+ * - `uint16_t` handle of the characteristic that sent the report,
+ * - `uint8_t` length of the report data,
+ * - the report data.
+ */
+class BLEReportCapture {
+ public:
+  /// @brief Size of the header preceding the data of every record.
+  static constexpr size_t recordHeaderLen = 7;
+
+  /// @brief Handle that matches the records of all characteristics when replaying.
+  static constexpr uint16_t anyHandle = 0;
+
+  BLEReportCapture(const BLEReportCapture&) = delete;
+  BLEReportCapture& operator=(const BLEReportCapture&) = delete;
+
+  static void start(uint8_t buffer[], size_t capacity);
+  static void stop();
+  static size_t read(uint8_t out[], size_t maxLen, uint32_t* pDropped = nullptr);
+  static bool isActive() { return _active.load(std::memory_order_relaxed); }
+  static void record(uint16_t handle, const uint8_t data[], size_t dataLen, int64_t timestampUs);
+
+  /**
+   * @brief Feeds the reports of a capture through a value receiver, as if they were received from a controller.
+   *
+   * Decoding, skipping of identical reports, event recording and value changed callbacks all behave as for live
+   * notifications. Replayed reports are not captured again. For controllers with several receivers specify the value
+   * type explicitly, e.g. `BLEReportCapture::replay<XboxControlsState>(controller, ...)`.
+   *
+   * The reports are handled on the calling task, so a receiver of a connected controller is refused, its live
+   * notifications would be handled concurrently. Replay into a controller instance that is not connected.
+   * @param receiver Receiver to feed the reports to.
+   * @param capture Capture data, as returned by `read()`.
+   * @param captureLen Length of the capture data.
+   * @param handle Handle of the characteristic whose reports to replay, or `anyHandle` to replay all of them.
+   * @param recordedSpeed If true, waits between reports as long as between their recording, at tick resolution.
+   * Otherwise replays the reports as fast as possible.
+   * @return Number of replayed reports, 0 if the receiver is subscribed to a connected controller.
+   */
+  template <typename T>
+  static size_t replay(BLEValueReceiver<T>& receiver,
+                       const uint8_t capture[],
+                       const size_t captureLen,
+                       const uint16_t handle,
+                       const bool recordedSpeed) {
+    if (receiver._subscribed) {
+      BLEGC_LOGE("Cannot replay reports into the receiver of a connected controller");
+      return 0;
+    }
+
+    uint8_t report[UINT8_MAX];
+    size_t count = 0;
+    bool first = true;
+    uint32_t prevTimestampUs = 0;
+    int64_t dueUs = 0;
+
+    size_t offset = 0;
+    while (offset + recordHeaderLen <= captureLen) {
+      const uint8_t* pRecord = capture + offset;
+      const uint32_t timestampUs = pRecord[0] | pRecord[1] << 8 | pRecord[2] << 16 | pRecord[3] << 24;
+      const uint16_t recordHandle = pRecord[4] | pRecord[5] << 8;
+      const uint8_t dataLen = pRecord[6];
+      if (offset + recordHeaderLen + dataLen > captureLen) {
+        break;
+      }
+      offset += recordHeaderLen + dataLen;
+
+      if (handle != anyHandle && recordHandle != handle) {
+        continue;
+      }
+
+      if (recordedSpeed) {
+        // unsigned subtraction keeps the delay correct across a wrap of the 32-bit timestamp
+        dueUs = first ? esp_timer_get_time() : dueUs + static_cast<uint32_t>(timestampUs - prevTimestampUs);
+        int64_t nowUs;
+        while ((nowUs = esp_timer_get_time()) < dueUs) {
+          const auto ticks = pdMS_TO_TICKS((dueUs - nowUs) / 1000);
+          vTaskDelay(ticks > 0 ? ticks : 1);
+        }
+      }
+      first = false;
+      prevTimestampUs = timestampUs;
+
+      // the notification handler takes a mutable buffer
+      memcpy(report, pRecord + recordHeaderLen, dataLen);
+      receiver._handleNotify(nullptr, report, dataLen);
+      count++;
+    }
+
+    return count;
+  }
+
+ private:
+  static size_t _peek(size_t offset);
+
+  static std::atomic_bool _active;
+  static SemaphoreHandle_t _mutex;
+  static uint8_t* _pBuffer;
+  static size_t _capacity;
+  static size_t _head;
+  static size_t _count;
+  static uint32_t _dropped;
+};
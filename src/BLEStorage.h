@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Key-value storage for data that the library keeps between sessions, such as attributes read from connected
+ * controllers. Keys are at most 15 characters long.
+ */
+class BLEStorage {
+ public:
+  virtual ~BLEStorage() = default;
+
+  /**
+   * @brief Returns the length of the value stored under the key.
+   * @param key Key of the value.
+   * @return Length of the value, or 0 if there is no value under the key.
+   */
+  virtual size_t length(const char* key) = 0;
+
+  /**
+   * @brief Reads the value stored under the key.
+   * @param key Key of the value.
+   * @param[out] buffer Buffer where the value will be written.
+   * @param bufferLen Length of the buffer.
+   * @return Number of bytes written, or 0 if there is no value under the key or it does not fit in the buffer.
+   */
+  virtual size_t read(const char* key, uint8_t buffer[], size_t bufferLen) = 0;
+
+  /**
+   * @brief Stores the value under the key, replacing the previous value.
+   * @param key Key of the value.
+   * @param data Value data.
+   * @param dataLen Length of the value data.
+   * @return True if the value was stored, false otherwise.
+   */
+  virtual bool write(const char* key, const uint8_t data[], size_t dataLen) = 0;
+
+  /**
+   * @brief Removes the value stored under the key.
+   * @param key Key of the value.
+   * @return True if the value was removed or did not exist, false otherwise.
+   */
+  virtual bool remove(const char* key) = 0;
+};
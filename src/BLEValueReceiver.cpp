@@ -1,9 +1,13 @@
 #include "BLEValueReceiver.h"
 
 #include <NimBLEDevice.h>
+#include <esp_timer.h>
 #include <bitset>
 #include <functional>
+#include "BLEDispatcher.h"
+#include "BLEReportCapture.h"
 #include "logger.h"
+#include "hid/HIDGamepadState.h"
 #include "steam/SteamControlsState.h"
 #include "utils.h"
 #include "xbox/XboxBatteryState.h"
@@ -11,45 +15,94 @@
 
 template <typename T>
 BLEValueReceiver<T>::BLEValueReceiver()
-    :
-      _callbackTask(nullptr),
-      _storeMutex(nullptr),
-      _store(),
+    : _store(),
+      _onActivityCallback(nullptr),
+      _onActivityArg(nullptr),
+      _subscribed(false),
+      _onRawReportCallback(nullptr),
+      _onRawReportArg(nullptr),
       _onValueChangedCallback(),
-      _onValueChangedCallbackSet(false) {
-  _storeMutex = xSemaphoreCreateMutex();
-  configASSERT(_storeMutex);
-  xTaskCreate(_callbackTaskFn, "_callbackTask", 10000, this, 0, &_callbackTask);
-  configASSERT(_callbackTask);
+      _onValueOnlyChangedCallback(),
+      _callbackPending(false),
+      _pendingChangedFields(0),
+#if CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+      _rawReport(),
+      _decodeMutex(xSemaphoreCreateMutex()),
+      _decodedGeneration(0),
+      _receivedGeneration(0),
+#endif
+      _eventsMutex(xSemaphoreCreateMutex()),
+      _events(),
+      _eventsEnabled(false),
+      _lastReport(),
+      _lastReportLen(0),
+      _reportCount(0),
+      _skippedReportCount(0) {
+#if CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+  configASSERT(_decodeMutex);
+#endif
+  configASSERT(_eventsMutex);
 }
 
 template <typename T>
 BLEValueReceiver<T>::~BLEValueReceiver() {
-  if (_callbackTask != nullptr) {
-    vTaskDelete(_callbackTask);
-    _callbackTask = nullptr;
+#if CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+  if (_decodeMutex != nullptr) {
+    vSemaphoreDelete(_decodeMutex);
+    _decodeMutex = nullptr;
   }
-  if (_storeMutex != nullptr) {
-    vSemaphoreDelete(_storeMutex);
-    _storeMutex = nullptr;
+#endif
+  if (_eventsMutex != nullptr) {
+    vSemaphoreDelete(_eventsMutex);
+    _eventsMutex = nullptr;
   }
 }
 
 template <typename T>
 bool BLEValueReceiver<T>::init(NimBLERemoteCharacteristic* pChar) {
+  return init(pChar, T());
+}
+
+template <typename T>
+bool BLEValueReceiver<T>::init(NimBLERemoteCharacteristic* pChar, const T& initialValue) {
   if (!pChar) {
     return false;
   }
 
-  _store = Store();
-
   if (!pChar->canNotify()) {
     BLEGC_LOGE("Characteristic not able to notify. %s", blegc::remoteCharToStr(pChar).c_str());
     return false;
   }
 
-  auto handlerFn = std::bind(&BLEValueReceiver::_handleNotify, this, std::placeholders::_1, std::placeholders::_2,
-                             std::placeholders::_3, std::placeholders::_4);
+  // reset the state before subscribing, afterwards the notification handler is the only writer
+  _subscribed = false;
+  _lastReportLen = 0;
+  _reportCount = 0;
+  _skippedReportCount = 0;
+
+  auto& value = _store.beginWrite();
+  value = initialValue;
+  auto* pClient = pChar->getClient();
+  if (pClient) {
+    value.controllerAddress = pClient->getPeerAddress();
+  }
+  _store.endWrite();
+
+#if CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+  configASSERT(xSemaphoreTake(_decodeMutex, portMAX_DELAY));
+  _receivedGeneration = 0;
+  _decodedGeneration = 0;
+  auto& report = _rawReport.beginWrite();
+  report.dataLen = 0;
+  report.generation = 0;
+  _rawReport.endWrite();
+  configASSERT(xSemaphoreGive(_decodeMutex));
+#endif
+
+  // capturing only `this` fits into the small buffer of std::function, so subscribing does not allocate
+  auto handlerFn = [this](NimBLERemoteCharacteristic* pChar, uint8_t* pData, size_t dataLen, bool) {
+    _handleNotify(pChar, pData, dataLen);
+  };
 
   BLEGC_LOGD("Subscribing to notifications. %s", blegc::remoteCharToStr(pChar).c_str());
 
@@ -59,77 +112,282 @@ bool BLEValueReceiver<T>::init(NimBLERemoteCharacteristic* pChar) {
   }
 
   BLEGC_LOGD("Successfully subscribed to notifications. %s", blegc::remoteCharToStr(pChar).c_str());
-
-  auto* pClient = pChar->getClient();
-  if (pClient) {
-    _store.value.controllerAddress = pClient->getPeerAddress();
-  }
+  _subscribed = true;
   return true;
 }
 
+/**
+ * @brief Marks the receiver as no longer subscribed, called once the controller disconnected.
+ */
+template <typename T>
+void BLEValueReceiver<T>::deinit() {
+  _subscribed = false;
+}
+
+/**
+ * @brief Sets a callback invoked from the notification handler whenever a report changes the value, or with lazy
+ * decoding enabled, whenever a report differs from the previous one. Used by controllers to track input activity, must
+ * not block.
+ */
+template <typename T>
+void BLEValueReceiver<T>::setActivityCallback(OnActivityFn callback, void* pArg) {
+  _onActivityArg = pArg;
+  _onActivityCallback = callback;
+}
+
 template <typename T>
 void BLEValueReceiver<T>::read(T* value) {
-  configASSERT(xSemaphoreTake(_storeMutex, portMAX_DELAY));
-  *value = _store.value;
-  configASSERT(xSemaphoreGive(_storeMutex));
+#if CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+  _decodeLatest();
+#endif
+  _store.read(value);
 }
 
 template <typename T>
 void BLEValueReceiver<T>::onValueChanged(const OnValueChanged<T>& callback) {
-  _onValueChangedCallback = callback;
-  _onValueChangedCallbackSet = true;
+  BLEDispatcher::init();
+  _onValueChangedCallback.set(nullptr, nullptr);
+  _onValueOnlyChangedCallback = callback;
+}
+
+template <typename T>
+void BLEValueReceiver<T>::onValueChanged(const OnFieldsChanged<T>& callback) {
+  BLEDispatcher::init();
+  _onValueOnlyChangedCallback = nullptr;
+  _onValueChangedCallback.set(callback);
+}
+
+template <typename T>
+void BLEValueReceiver<T>::onValueChanged(OnFieldsChangedFn<T> callback, void* pArg) {
+  BLEDispatcher::init();
+  _onValueOnlyChangedCallback = nullptr;
+  _onValueChangedCallback.set(callback, pArg);
 }
 
 template <typename T>
-void BLEValueReceiver<T>::_callbackTaskFn(void* pvParameters) {
-  auto* self = static_cast<BLEValueReceiver*>(pvParameters);
+void BLEValueReceiver<T>::onRawReport(OnRawReport<T> callback, void* pArg) {
+  _onRawReportArg = pArg;
+  _onRawReportCallback = callback;
+}
 
-  while (true) {
-    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+template <typename T>
+void BLEValueReceiver<T>::setEventBuffer([[maybe_unused]] BLEValueEvent<T> events[],
+                                         [[maybe_unused]] const size_t capacity) {
+#if CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+  BLEGC_LOGE("Event buffer is not supported with lazy decoding enabled");
+#else
+  configASSERT(xSemaphoreTake(_eventsMutex, portMAX_DELAY));
+  const auto nextSeq = _events.nextSeq;
+  _events = EventBuffer();
+  _events.pEvents = capacity > 0 ? events : nullptr;
+  _events.capacity = _events.pEvents ? capacity : 0;
+  _events.nextSeq = nextSeq;
+  _eventsEnabled = _events.capacity > 0;
+  configASSERT(xSemaphoreGive(_eventsMutex));
+#endif
+}
 
-    configASSERT(xSemaphoreTake(self->_storeMutex, portMAX_DELAY));
-    auto valueCopy = self->_store.value;
-    configASSERT(xSemaphoreGive(self->_storeMutex));
-    self->_onValueChangedCallback(valueCopy);
+template <typename T>
+size_t BLEValueReceiver<T>::drain(BLEValueEvent<T> events[], const size_t maxCount, uint32_t* pDropped) {
+  configASSERT(xSemaphoreTake(_eventsMutex, portMAX_DELAY));
+  const auto count = min(_events.count, maxCount);
+  const auto tail = count > 0 ? (_events.head + _events.capacity - _events.count) % _events.capacity : 0;
+  for (size_t i = 0; i < count; i++) {
+    events[i] = _events.pEvents[(tail + i) % _events.capacity];
   }
+  _events.count -= count;
+  if (pDropped) {
+    *pDropped = _events.dropped;
+    _events.dropped = 0;
+  }
+  configASSERT(xSemaphoreGive(_eventsMutex));
+
+  return count;
+}
+
+template <typename T>
+void BLEValueReceiver<T>::readStats(BLEValueReceiverStats<T>* stats) const {
+  stats->reports = _reportCount.load(std::memory_order_relaxed);
+  stats->skippedReports = _skippedReportCount.load(std::memory_order_relaxed);
 }
 
 template <typename T>
-void BLEValueReceiver<T>::_handleNotify(NimBLERemoteCharacteristic* pChar,
-                                        uint8_t* pData,
-                                        size_t dataLen,
-                                        bool isNotify) {
-  BLEGC_LOGV("Received a notification. %s", blegc::remoteCharToStr(pChar).c_str());
+void BLEValueReceiver<T>::_recordEvent(const T& value, const int64_t timestampUs) {
+  // called from the notification handler, which must not block while the buffer is being drained
+  if (xSemaphoreTake(_eventsMutex, 0) != pdTRUE) {
+    _events.dropped++;  // drain() resets it under the mutex, a lost increment only affects the statistics
+    return;
+  }
+
+  if (_events.capacity > 0) {
+    auto& event = _events.pEvents[_events.head];
+    event.value = value;
+    event.timestampUs = timestampUs;
+    event.seq = _events.nextSeq++;
+
+    _events.head = (_events.head + 1) % _events.capacity;
+    if (_events.count < _events.capacity) {
+      _events.count++;
+    } else {
+      _events.dropped++;
+    }
+  }
+  configASSERT(xSemaphoreGive(_eventsMutex));
+}
 
-  configASSERT(xSemaphoreTake(_storeMutex, portMAX_DELAY));
-  BLEDecodeResult result;
-  bool runCallback;
-  if (_onValueChangedCallbackSet) {
-    auto valueCopy = _store.value;
-    result = _store.value.decode(pData, dataLen);
-    runCallback = valueCopy != _store.value;
+template <typename T>
+void BLEValueReceiver<T>::_callbackFn(void* pArg) {
+  auto* self = static_cast<BLEValueReceiver*>(pArg);
+
+  // clear the flag before reading, so a report received after the read schedules another callback
+  self->_callbackPending = false;
+#if CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+  self->_decodeLatest();
+#endif
+  const auto changedFields = self->_pendingChangedFields.exchange(0);
+  if (changedFields == 0) {
+    // already delivered by the previous invocation, or the report did not change the value
+    return;
+  }
+
+  T valueCopy;
+  self->_store.read(&valueCopy);
+  if (self->_onValueOnlyChangedCallback) {
+    self->_onValueOnlyChangedCallback(valueCopy);
   } else {
-    result = _store.value.decode(pData, dataLen);
-    runCallback = false;
+    self->_onValueChangedCallback(valueCopy, changedFields);
   }
+}
+
+template <typename T>
+bool BLEValueReceiver<T>::_hasValueChangedCallback() const {
+  return _onValueChangedCallback || _onValueOnlyChangedCallback;
+}
+
+template <typename T>
+BLEDecodeResult BLEValueReceiver<T>::_decode(T& value, uint8_t* pData, const size_t dataLen, uint32_t& changedFields) {
+  const auto result = value.decode(pData, dataLen, changedFields);
 
 #if CONFIG_BT_BLEGC_LOG_BUFFER_ENABLED
   if (result == BLEDecodeResult::Success) {
-    if (_store.value.reportDataCap < dataLen) {
-      _store.value.reportData = std::make_shared<uint8_t[]>(dataLen);
-      _store.value.reportDataCap = dataLen;
-    }
+    value.captureReportData(pData, dataLen);
+  }
+#endif
+  return result;
+}
+
+#if CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+template <typename T>
+void BLEValueReceiver<T>::_decodeLatest() {
+  configASSERT(xSemaphoreTake(_decodeMutex, portMAX_DELAY));
+
+  // readers holding the mutex are the only writers of the value in lazy mode
+  RawReport report;
+  _rawReport.read(&report);
+  if (report.generation != _decodedGeneration) {
+    _decodedGeneration = report.generation;
 
-    _store.value.reportDataLen = dataLen;
-    memcpy(_store.value.reportData.get(), pData, dataLen);
+    uint32_t changedFields = 0;
+    auto& value = _store.beginWrite();
+    const auto result = _decode(value, report.data, report.dataLen, changedFields);
+    _store.endWrite();
+
+    switch (result) {
+      case BLEDecodeResult::Success:
+        if (changedFields != 0 && _hasValueChangedCallback()) {
+          _pendingChangedFields.fetch_or(changedFields);
+        }
+        break;
+      case BLEDecodeResult::NotSupported:
+        BLEGC_LOGV("Report not supported");
+        break;
+      case BLEDecodeResult::InvalidReport:
+        BLEGC_LOGE("Invalid report");
+        break;
+    }
   }
+
+  configASSERT(xSemaphoreGive(_decodeMutex));
+}
 #endif
-  configASSERT(xSemaphoreGive(_storeMutex));
+
+template <typename T>
+void BLEValueReceiver<T>::_handleNotify(NimBLERemoteCharacteristic* pChar, uint8_t* pData, size_t dataLen) {
+  _reportCount.fetch_add(1, std::memory_order_relaxed);
+
+  // replayed reports come without a characteristic
+  if (pChar && BLEReportCapture::isActive()) {
+    BLEReportCapture::record(pChar->getHandle(), pData, dataLen, esp_timer_get_time());
+  }
+
+  if (_onRawReportCallback) {
+    _onRawReportCallback(BLERawReport<T>{pData, dataLen, esp_timer_get_time()}, _onRawReportArg);
+  }
+
+  // controllers keep sending identical reports while idle, these can't change the value
+  if (dataLen == _lastReportLen && memcmp(_lastReport, pData, dataLen) == 0) {
+    _skippedReportCount.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  if (BLEGC_LOG_ENABLED(ESP_LOG_VERBOSE)) {
+    BLEGC_LOGV("Received a notification. %s", blegc::remoteCharToStr(pChar).c_str());
+  }
+
+#if CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+  if (dataLen > sizeof(_lastReport)) {
+    BLEGC_LOGE("Report too long to be decoded lazily, length: %zu. %s", dataLen, blegc::remoteCharToStr(pChar).c_str());
+    return;
+  }
+
+  // decoding is left to the next reader, activity is tracked even if nobody reads
+  memcpy(_lastReport, pData, dataLen);
+  _lastReportLen = dataLen;
+  if (_onActivityCallback) {
+    _onActivityCallback(_onActivityArg);
+  }
+
+  auto& report = _rawReport.beginWrite();
+  memcpy(report.data, pData, dataLen);
+  report.dataLen = dataLen;
+  report.generation = ++_receivedGeneration;
+  _rawReport.endWrite();
+
+  if (_hasValueChangedCallback() && !_callbackPending.exchange(true) && !BLEDispatcher::post(_callbackFn, this)) {
+    _callbackPending = false;
+  }
+#else
+  const auto timestampUs = esp_timer_get_time();
+  uint32_t changedFields = 0;
+
+  auto& value = _store.beginWrite();
+  const auto result = _decode(value, pData, dataLen, changedFields);
+  _store.endWrite();
 
   switch (result) {
     case BLEDecodeResult::Success:
-      if (runCallback) {
-        xTaskNotifyGive(_callbackTask);
+      if (dataLen <= sizeof(_lastReport)) {
+        memcpy(_lastReport, pData, dataLen);
+        _lastReportLen = dataLen;
+      } else {
+        _lastReportLen = 0;
+      }
+
+      if (changedFields == 0) {
+        break;
+      }
+      if (_onActivityCallback) {
+        _onActivityCallback(_onActivityArg);
+      }
+      // this handler is the only writer, so the value can still be read after publishing it
+      if (_eventsEnabled) {
+        _recordEvent(value, timestampUs);
+      }
+      if (_hasValueChangedCallback()) {
+        _pendingChangedFields.fetch_or(changedFields);
+        if (!_callbackPending.exchange(true) && !BLEDispatcher::post(_callbackFn, this)) {
+          _callbackPending = false;
+        }
       }
       break;
     case BLEDecodeResult::NotSupported:
@@ -139,8 +397,10 @@ void BLEValueReceiver<T>::_handleNotify(NimBLERemoteCharacteristic* pChar,
       BLEGC_LOGE("Invalid report. %s", blegc::remoteCharToStr(pChar).c_str());
       break;
   }
+#endif
 }
 
 template class BLEValueReceiver<XboxControlsState>;
 template class BLEValueReceiver<XboxBatteryState>;
 template class BLEValueReceiver<SteamControlsState>;
+template class BLEValueReceiver<HIDGamepadState>;
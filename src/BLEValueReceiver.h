@@ -1,19 +1,75 @@
 #pragma once
 
 #include <NimBLEDevice.h>
+#include <atomic>
 #include <functional>
+#include "BLEBaseValue.h"
+#include "BLECallback.h"
+#include "BLEValueSnapshot.h"
+#include "config.h"
 
 template <typename T>
 using OnValueChanged = std::function<void(T& value)>;
 
+template <typename T>
+using OnFieldsChanged = std::function<void(T& value, uint32_t changedFields)>;
+
+template <typename T>
+using OnFieldsChangedFn = void (*)(T& value, uint32_t changedFields, void* pArg);
+
+template <typename T>
+struct BLERawReport {
+  /// @brief Report data, as received from the controller. Only valid for the duration of the callback.
+  const uint8_t* data;
+
+  /// @brief Length of the report data.
+  size_t dataLen;
+
+  /// @brief Time at which the report was received, in microseconds since boot.
+  int64_t timestampUs;
+};
+
+template <typename T>
+using OnRawReport = void (*)(const BLERawReport<T>& report, void* pArg);
+
+using OnActivityFn = void (*)(void* pArg);
+
+template <typename T>
+struct BLEValueEvent {
+  /// @brief Value received from the controller.
+  T value{};
+
+  /// @brief Time at which the value was received, in microseconds since boot.
+  int64_t timestampUs{0};
+
+  /// @brief Sequence number of the event. Incremented by one for every recorded event, a gap between two consecutive
+  /// events means that the events in between were dropped.
+  uint32_t seq{0};
+};
+
+template <typename T>
+struct BLEValueReceiverStats {
+  /// @brief Number of notifications received since the controller connected.
+  uint32_t reports{0};
+
+  /// @brief Number of notifications skipped without decoding, because they were identical to the previous one.
+  uint32_t skippedReports{0};
+};
+
+class BLEReportCapture;
+
 template <typename T>
 class BLEValueReceiver {
+  friend class BLEReportCapture;
+
  public:
   BLEValueReceiver();
   ~BLEValueReceiver();
 
   /**
-   * @brief Read the latest value from the connected controller.
+   * @brief Read the latest value from the connected controller. Never blocks on the notification handler. With lazy
+   * decoding enabled, decodes the latest report if it has not been decoded yet, and waits while another reader, e.g.
+   * the value changed callback, is decoding it.
    * @param[out] value Pointer to the value instance where the data will be written.
    */
   void read(T* value);
@@ -24,19 +80,113 @@ class BLEValueReceiver {
    */
   void onValueChanged(const OnValueChanged<T>& callback);
 
+  /**
+   * @brief Sets a callback that is invoked whenever the value changes, together with the fields that changed.
+   * @param callback The function to call when a new value is received that differs from the previous one. Receives a
+   * mask of `T::Field` bits of the fields that changed since the previous invocation.
+   */
+  void onValueChanged(const OnFieldsChanged<T>& callback);
+
+  /**
+   * @brief Same as `onValueChanged(const OnFieldsChanged<T>&)`, but stores a plain function pointer, so that setting
+   * and invoking the callback never allocates.
+   * @param callback The function to call when a new value is received that differs from the previous one.
+   * @param pArg Argument passed to the callback.
+   */
+  void onValueChanged(OnFieldsChangedFn<T> callback, void* pArg);
+
+  /**
+   * @brief Sets a callback that is invoked with every report received from the controller, before it is decoded.
+   *
+   * The callback runs directly on the NimBLE host task, without the hop to the dispatcher task and the copy of the
+   * value that `onValueChanged()` involves, which makes it suitable for reacting to a report with the lowest possible
+   * latency. It must not block nor do lengthy work, as this delays every other BLE event, including reports from
+   * other controllers.
+   * @param callback The function to call when a report is received. Pass `nullptr` to remove the callback.
+   * @param pArg Optional, argument passed to the callback.
+   */
+  void onRawReport(OnRawReport<T> callback, void* pArg = nullptr);
+
+  /**
+   * @brief Enables recording of every value change into a ring buffer, so that changes happening between two reads
+   * are not lost. When the buffer is full the oldest event is dropped. Events are retrieved with `drain()`. Not
+   * supported with lazy decoding enabled.
+   * @param events Storage for the events. Must stay valid until the buffer is replaced or disabled.
+   * @param capacity Number of events the storage can hold. Pass 0 to disable recording.
+   */
+  void setEventBuffer(BLEValueEvent<T> events[], size_t capacity);
+
+  /**
+   * @brief Moves the recorded events, oldest first, out of the ring buffer.
+   * @param[out] events Array where the events will be written.
+   * @param maxCount Maximum number of events to write.
+   * @param[out] pDropped Optional, number of events dropped since the previous drain, due to a full buffer or because
+   * the buffer was being drained when the value changed.
+   * @return Number of events written.
+   */
+  size_t drain(BLEValueEvent<T> events[], size_t maxCount, uint32_t* pDropped = nullptr);
+
+  /**
+   * @brief Read the statistics of the notifications received from the connected controller.
+   * @param[out] stats Pointer to the stats instance where the data will be written.
+   */
+  void readStats(BLEValueReceiverStats<T>* stats) const;
+
  protected:
   bool init(NimBLERemoteCharacteristic* pChar);
+  bool init(NimBLERemoteCharacteristic* pChar, const T& initialValue);
+  void deinit();
+  void setActivityCallback(OnActivityFn callback, void* pArg);
 
  private:
-  struct Store {
-    T value{};
+  struct EventBuffer {
+    BLEValueEvent<T>* pEvents{nullptr};
+    size_t capacity{0};
+    size_t head{0};
+    size_t count{0};
+    uint32_t nextSeq{0};
+    uint32_t dropped{0};
+  };
+
+#if CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+  struct RawReport {
+    uint8_t data[CONFIG_BT_BLEGC_RECEIVER_LAST_REPORT_MAX_LEN];
+    size_t dataLen;
+    uint32_t generation;
   };
-  static void _callbackTaskFn(void* pvParameters);
-  void _handleNotify(NimBLERemoteCharacteristic* pChar, uint8_t* pData, size_t dataLen, bool isNotify);
-
-  TaskHandle_t _callbackTask;
-  SemaphoreHandle_t _storeMutex;
-  Store _store;
-  OnValueChanged<T> _onValueChangedCallback;
-  bool _onValueChangedCallbackSet;
+#endif
+
+  static void _callbackFn(void* pArg);
+  bool _hasValueChangedCallback() const;
+  static BLEDecodeResult _decode(T& value, uint8_t* pData, size_t dataLen, uint32_t& changedFields);
+  void _recordEvent(const T& value, int64_t timestampUs);
+  void _handleNotify(NimBLERemoteCharacteristic* pChar, uint8_t* pData, size_t dataLen);
+#if CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+  void _decodeLatest();
+#endif
+
+  BLEValueSnapshot<T> _store;
+  OnActivityFn _onActivityCallback;
+  void* _onActivityArg;
+  std::atomic_bool _subscribed;
+  OnRawReport<T> _onRawReportCallback;
+  void* _onRawReportArg;
+  BLECallback<T&, uint32_t> _onValueChangedCallback;
+  // a callback without the changed fields is stored as is rather than wrapped into `_onValueChangedCallback`
+  OnValueChanged<T> _onValueOnlyChangedCallback;
+  std::atomic_bool _callbackPending;
+  std::atomic<uint32_t> _pendingChangedFields;
+#if CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+  BLEValueSnapshot<RawReport> _rawReport;
+  SemaphoreHandle_t _decodeMutex;
+  uint32_t _decodedGeneration;
+  uint32_t _receivedGeneration;
+#endif
+  SemaphoreHandle_t _eventsMutex;
+  EventBuffer _events;
+  std::atomic_bool _eventsEnabled;
+  uint8_t _lastReport[CONFIG_BT_BLEGC_RECEIVER_LAST_REPORT_MAX_LEN];
+  size_t _lastReportLen;
+  std::atomic<uint32_t> _reportCount;
+  std::atomic<uint32_t> _skippedReportCount;
 };
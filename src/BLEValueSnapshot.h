@@ -0,0 +1,81 @@
+#pragma once
+
+#include <NimBLEDevice.h>
+#include <atomic>
+#include "logger.h"
+
+/**
+ * @brief Single-writer, multi-reader snapshot of a value, guarded by a sequence lock.
+ *
+ * The writer never waits for readers. Readers never take a lock; a read that overlaps with a write is retried until it
+ * observes a consistent copy.
+ *
+ * Values are not trivially copyable, `BLEBaseValue` has a virtual destructor. Their copy assignment must however only
+ * copy plain data members, such as the `Raw` payloads, as a read may copy a value while it is being written and only
+ * then discard the torn copy.
+ */
+template <typename T>
+class BLEValueSnapshot {
+ public:
+  BLEValueSnapshot() : _seq(0), _value() {}
+
+  BLEValueSnapshot(const BLEValueSnapshot&) = delete;
+  BLEValueSnapshot& operator=(const BLEValueSnapshot&) = delete;
+
+  /**
+   * @brief Starts a write. Must be followed by `endWrite()`. Only one task may write at a time.
+   * @return Reference to the stored value, valid until `endWrite()` is called.
+   */
+  T& beginWrite() {
+    _seq.store(_seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return _value;
+  }
+
+  /**
+   * @brief Publishes the value modified since `beginWrite()`.
+   */
+  void endWrite() {
+    _seq.store(_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Copies the latest published value.
+   * @param[out] value Pointer to the value instance where the data will be written.
+   */
+  void read(T* value) const {
+    read([value](const T& latest) { *value = latest; });
+  }
+
+  /**
+   * @brief Passes the latest published value to a function that copies the parts it needs. The function may be called
+   * again if the value was written meanwhile, it must copy plain data only and must not follow pointers it reads.
+   * @param copy Function called with the latest published value.
+   */
+  template <typename Fn>
+  void read(Fn&& copy) const {
+    unsigned int spins = 0;
+    while (true) {
+      const auto seqBefore = _seq.load(std::memory_order_acquire);
+      if ((seqBefore & 1) == 0) {
+        copy(static_cast<const T&>(_value));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_seq.load(std::memory_order_relaxed) == seqBefore) {
+          return;
+        }
+      }
+
+      // The writer may have been preempted by this task on the same core, give it a chance to finish.
+      if (++spins % maxSpins == 0) {
+        vTaskDelay(1);
+      }
+    }
+  }
+
+ private:
+  static constexpr unsigned int maxSpins = 64;
+  static_assert(std::atomic<uint32_t>::is_always_lock_free, "The sequence counter must be lock-free");
+
+  std::atomic<uint32_t> _seq;
+  T _value;
+};
@@ -2,6 +2,7 @@
 
 #include <NimBLEDevice.h>
 #include <functional>
+#include "BLEDispatcher.h"
 #include "logger.h"
 #include "utils.h"
 #include "config.h"
@@ -12,22 +13,16 @@ constexpr size_t INIT_CAPACITY = 8;
 
 template <typename T>
 BLEValueWriter<T>::BLEValueWriter()
-    : _pChar(nullptr), _sendDataTask(nullptr), _storeMutex(nullptr), _store() {
+    : _pChar(nullptr), _storeMutex(nullptr), _store(), _sendPending(false) {
   _store.capacity = INIT_CAPACITY;
   _store.pBuffer = new uint8_t[_store.capacity];
   _store.pSendBuffer = new uint8_t[_store.capacity];
 
   _storeMutex = xSemaphoreCreateMutex();
   configASSERT(_storeMutex);
-  xTaskCreate(_sendDataFn, "_sendDataFn", 10000, this, 0, &_sendDataTask);
-  configASSERT(_sendDataTask);
 }
 template <typename T>
 BLEValueWriter<T>::~BLEValueWriter() {
-  if (_sendDataTask != nullptr) {
-    vTaskDelete(_sendDataTask);
-    _sendDataTask = nullptr;
-  }
   if (_storeMutex != nullptr) {
     vSemaphoreDelete(_storeMutex);
     _storeMutex = nullptr;
@@ -71,20 +66,16 @@ void BLEValueWriter<T>::write(T& cmd) {
 
 #if CONFIG_BT_BLEGC_LOG_BUFFER_ENABLED
   if (result == BLEEncodeResult::Success) {
-    if (cmd.reportDataCap < _store.used) {
-      cmd.reportData = std::make_shared<uint8_t[]>(_store.used);
-      cmd.reportDataCap = _store.used;
-    }
-
-    cmd.reportDataLen = _store.used;
-    memcpy(cmd.reportData.get(), _store.pBuffer, _store.used);
+    cmd.captureReportData(_store.pBuffer, _store.used);
   }
 #endif
   configASSERT(xSemaphoreGive(_storeMutex));
 
   switch (result) {
     case BLEEncodeResult::Success:
-      xTaskNotifyGive(_sendDataTask);
+      if (!_sendPending.exchange(true) && !BLEDispatcher::post(_sendDataFn, this)) {
+        _sendPending = false;
+      }
       break;
     case BLEEncodeResult::InvalidValue:
       BLEGC_LOGE("Encoding failed, invalid value");
@@ -96,35 +87,33 @@ void BLEValueWriter<T>::write(T& cmd) {
 }
 
 template <typename T>
-void BLEValueWriter<T>::_sendDataFn(void* pvParameters) {
-  auto* self = static_cast<BLEValueWriter*>(pvParameters);
-
-  while (true) {
-    ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+void BLEValueWriter<T>::_sendDataFn(void* pArg) {
+  auto* self = static_cast<BLEValueWriter*>(pArg);
 
-    configASSERT(xSemaphoreTake(self->_storeMutex, portMAX_DELAY));
+  configASSERT(xSemaphoreTake(self->_storeMutex, portMAX_DELAY));
+  // cleared under the mutex, a write encoded after the buffer swap schedules another send
+  self->_sendPending = false;
 
-    uint8_t* tmp = self->_store.pSendBuffer;
-    self->_store.pSendBuffer = self->_store.pBuffer;
-    self->_store.pBuffer = tmp;
+  uint8_t* tmp = self->_store.pSendBuffer;
+  self->_store.pSendBuffer = self->_store.pBuffer;
+  self->_store.pBuffer = tmp;
 
-    auto used = self->_store.used;
-    auto shouldSend = self->_store.used > 0 && self->_store.used <= self->_store.capacity;
-    configASSERT(xSemaphoreGive(self->_storeMutex));
+  auto used = self->_store.used;
+  auto shouldSend = self->_store.used > 0 && self->_store.used <= self->_store.capacity;
+  configASSERT(xSemaphoreGive(self->_storeMutex));
 
-    if (!shouldSend) {
-      continue;
-    }
+  if (!shouldSend) {
+    return;
+  }
 
-    if (!self->_pChar) {
-      BLEGC_LOGD("Writer not initialized, sending data aborted");
-      continue;
-    }
+  if (!self->_pChar) {
+    BLEGC_LOGD("Writer not initialized, sending data aborted");
+    return;
+  }
 
-    BLEGC_LOGV("Writing value. %s", blegc::remoteCharToStr(self->_pChar).c_str());
+  BLEGC_LOGV("Writing value. %s", blegc::remoteCharToStr(self->_pChar).c_str());
 
-    self->_pChar->writeValue(self->_store.pSendBuffer, used);
-  }
+  self->_pChar->writeValue(self->_store.pSendBuffer, used);
 }
 
 template class BLEValueWriter<XboxVibrationsCommand>;
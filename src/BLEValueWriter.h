@@ -1,6 +1,7 @@
 #pragma once
 
 #include <NimBLEDevice.h>
+#include <atomic>
 
 template <typename T>
 class BLEValueWriter {
@@ -24,10 +25,10 @@ class BLEValueWriter {
     size_t used{};
     size_t capacity{};
   };
-  static void _sendDataFn(void* pvParameters);
+  static void _sendDataFn(void* pArg);
 
   NimBLERemoteCharacteristic* _pChar;
-  TaskHandle_t _sendDataTask;
   SemaphoreHandle_t _storeMutex;
   Store _store;
+  std::atomic_bool _sendPending;
 };
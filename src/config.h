@@ -8,6 +8,46 @@
 #define CONFIG_BT_BLEGC_WRITER_BUFFER_MAX_CAPACITY 1024
 #endif
 
+#ifndef CONFIG_BT_BLEGC_DISPATCHER_STACK_SIZE
+#define CONFIG_BT_BLEGC_DISPATCHER_STACK_SIZE 10000
+#endif
+
+#ifndef CONFIG_BT_BLEGC_DISPATCHER_QUEUE_LENGTH
+#define CONFIG_BT_BLEGC_DISPATCHER_QUEUE_LENGTH 16
+#endif
+
+#ifndef CONFIG_BT_BLEGC_RECEIVER_LAST_REPORT_MAX_LEN
+#define CONFIG_BT_BLEGC_RECEIVER_LAST_REPORT_MAX_LEN 32
+#endif
+
+#ifndef CONFIG_BT_BLEGC_LOG_BUFFER_REPORT_MAX_LEN
+#define CONFIG_BT_BLEGC_LOG_BUFFER_REPORT_MAX_LEN 64
+#endif
+
+#ifndef CONFIG_BT_BLEGC_HID_MAX_DECODE_STEPS
+#define CONFIG_BT_BLEGC_HID_MAX_DECODE_STEPS 24
+#endif
+
+#ifndef CONFIG_BT_BLEGC_CONN_TIMINGS_HISTORY
+#define CONFIG_BT_BLEGC_CONN_TIMINGS_HISTORY 8
+#endif
+
+#ifndef CONFIG_BT_BLEGC_ADAPTIVE_IDLE_TIMEOUT_MS
+#define CONFIG_BT_BLEGC_ADAPTIVE_IDLE_TIMEOUT_MS 3000
+#endif
+
+#ifndef CONFIG_BT_BLEGC_MAX_CONTROLLERS
+#define CONFIG_BT_BLEGC_MAX_CONTROLLERS CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#endif
+
+#ifndef CONFIG_BT_BLEGC_ADV_MATCH_MAX_RULES
+#define CONFIG_BT_BLEGC_ADV_MATCH_MAX_RULES 16
+#endif
+
+#ifndef CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED
+#define CONFIG_BT_BLEGC_LAZY_DECODE_ENABLED 0
+#endif
+
 #ifndef CONFIG_BT_BLEGC_HIGH_DUTY_SCAN_DURATION_MS
 #define CONFIG_BT_BLEGC_HIGH_DUTY_SCAN_DURATION_MS 60000
 #endif
@@ -40,6 +80,22 @@
 #define CONFIG_BT_BLEGC_LOW_DUTY_SCAN_ACTIVE 0
 #endif
 
+#ifndef CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_ENABLED
+#define CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_ENABLED 0
+#endif
+
+#ifndef CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_INTERVAL_MS
+#define CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_INTERVAL_MS 60
+#endif
+
+#ifndef CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_WINDOW_MS
+#define CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_WINDOW_MS 30
+#endif
+
+#ifndef CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_TIMEOUT_MS
+#define CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_TIMEOUT_MS 10000
+#endif
+
 #ifndef CONFIG_BT_BLEGC_CONN_TIMEOUT_MS
 #define CONFIG_BT_BLEGC_CONN_TIMEOUT_MS 15000
 #endif
@@ -0,0 +1,335 @@
+#include "HIDDecodePlan.h"
+
+#include "logger.h"
+
+// Sources
+// https://www.usb.org/sites/default/files/hid1_11.pdf
+// https://usb.org/sites/default/files/hut1_5.pdf
+
+#define ITEM_TYPE_MAIN 0
+#define ITEM_TYPE_GLOBAL 1
+#define ITEM_TYPE_LOCAL 2
+#define LONG_ITEM_PREFIX 0xfe
+
+#define MAIN_INPUT 0x8
+#define MAIN_OUTPUT 0x9
+#define MAIN_COLLECTION 0xa
+#define MAIN_FEATURE 0xb
+#define MAIN_END_COLLECTION 0xc
+
+#define GLOBAL_USAGE_PAGE 0x0
+#define GLOBAL_LOGICAL_MIN 0x1
+#define GLOBAL_LOGICAL_MAX 0x2
+#define GLOBAL_REPORT_SIZE 0x7
+#define GLOBAL_REPORT_ID 0x8
+#define GLOBAL_REPORT_COUNT 0x9
+#define GLOBAL_PUSH 0xa
+#define GLOBAL_POP 0xb
+
+#define LOCAL_USAGE 0x0
+#define LOCAL_USAGE_MIN 0x1
+#define LOCAL_USAGE_MAX 0x2
+
+#define INPUT_CONSTANT 0x01
+#define INPUT_VARIABLE 0x02
+
+#define USAGE_PAGE_GENERIC_DESKTOP 0x01
+#define USAGE_PAGE_SIMULATION 0x02
+#define USAGE_PAGE_BUTTON 0x09
+
+#define USAGE_X 0x30
+#define USAGE_RZ 0x35
+#define USAGE_HAT_SWITCH 0x39
+#define USAGE_ACCELERATOR 0xc4
+#define USAGE_BRAKE 0xc5
+
+constexpr size_t maxLocalUsages = 16;
+constexpr size_t maxReportIds = 8;
+constexpr size_t maxGlobalStackDepth = 4;
+constexpr uint8_t acceleratorAxisIdx = 6;
+constexpr uint8_t brakeAxisIdx = 7;
+constexpr int64_t axisOutRange = 2 * 32767;
+constexpr int64_t restAxisOutRange = 32767;
+
+struct ReportOffset {
+  uint8_t reportId;
+  uint16_t bitOffset;
+};
+
+// global items, saved and restored as a whole by the push and pop items
+struct GlobalItems {
+  uint16_t usagePage;
+  int32_t logicalMin;
+  int32_t logicalMax;
+  uint32_t logicalMaxUnsigned;
+  uint32_t reportSize;
+  uint32_t reportCount;
+  uint8_t reportId;
+};
+
+static ReportOffset* findOffset(ReportOffset offsets[], size_t& offsetCount, const uint8_t reportId) {
+  for (size_t i = 0; i < offsetCount; i++) {
+    if (offsets[i].reportId == reportId) {
+      return &offsets[i];
+    }
+  }
+  if (offsetCount == maxReportIds) {
+    return nullptr;
+  }
+  offsets[offsetCount] = {reportId, 0};
+  return &offsets[offsetCount++];
+}
+
+static bool mapUsage(const uint32_t usage, HIDDecodePlan::Target& target, uint8_t& index) {
+  const uint16_t page = usage >> 16;
+  const uint16_t id = usage & 0xffff;
+
+  if (page == USAGE_PAGE_BUTTON && id >= 1 && id <= HIDDecodePlan::maxButtons) {
+    target = HIDDecodePlan::Target::Buttons;
+    index = id - 1;
+    return true;
+  }
+
+  if (page == USAGE_PAGE_GENERIC_DESKTOP && id >= USAGE_X && id <= USAGE_RZ) {
+    target = HIDDecodePlan::Target::Axis;
+    index = id - USAGE_X;
+    return true;
+  }
+
+  if (page == USAGE_PAGE_GENERIC_DESKTOP && id == USAGE_HAT_SWITCH) {
+    target = HIDDecodePlan::Target::Hat;
+    index = 0;
+    return true;
+  }
+
+  if (page == USAGE_PAGE_SIMULATION && (id == USAGE_ACCELERATOR || id == USAGE_BRAKE)) {
+    target = HIDDecodePlan::Target::RestAxis;
+    index = id == USAGE_ACCELERATOR ? acceleratorAxisIdx : brakeAxisIdx;
+    return true;
+  }
+
+  return false;
+}
+
+HIDDecodePlan::HIDDecodePlan() : _steps(), _stepCount(0), _minReportLen(0), _reportId(0) {}
+
+/**
+ * @brief Compiles the report descriptor into a decode plan. Only the first input report that contains gamepad controls
+ * is decoded, controls of other reports are ignored.
+ * @param reportMap HID report descriptor, as read from the report map characteristic.
+ * @param reportMapLen Length of the report descriptor.
+ * @return True if the report descriptor contains at least one gamepad control, false otherwise.
+ */
+bool HIDDecodePlan::parse(const uint8_t reportMap[], const size_t reportMapLen) {
+  *this = HIDDecodePlan();
+
+  GlobalItems globals{};
+  GlobalItems globalStack[maxGlobalStackDepth];
+  size_t globalStackDepth = 0;
+
+  // local items
+  uint32_t usages[maxLocalUsages];
+  size_t usageCount = 0;
+  uint32_t usageMin = 0;
+  uint32_t usageMax = 0;
+
+  // input reports are laid out independently of each other
+  ReportOffset offsets[maxReportIds] = {};
+  size_t offsetCount = 1;
+  ReportOffset* pOffset = &offsets[0];
+
+  bool reportChosen = false;
+
+  size_t pos = 0;
+  while (pos < reportMapLen) {
+    const uint8_t prefix = reportMap[pos++];
+    if (prefix == LONG_ITEM_PREFIX) {
+      if (pos >= reportMapLen) {
+        break;
+      }
+      pos += 2 + reportMap[pos];
+      continue;
+    }
+
+    const size_t size = (prefix & 0x03) == 3 ? 4 : prefix & 0x03;
+    const uint8_t type = (prefix >> 2) & 0x03;
+    const uint8_t tag = prefix >> 4;
+    if (pos + size > reportMapLen) {
+      BLEGC_LOGE("Report map truncated at offset %zu", pos);
+      break;
+    }
+
+    uint32_t udata = 0;
+    for (size_t i = 0; i < size; i++) {
+      udata |= static_cast<uint32_t>(reportMap[pos + i]) << (8 * i);
+    }
+    const uint8_t signShift = size == 0 ? 0 : 32 - 8 * size;
+    const int32_t sdata = static_cast<int32_t>(udata << signShift) >> signShift;
+    pos += size;
+
+    if (type == ITEM_TYPE_GLOBAL) {
+      switch (tag) {
+        case GLOBAL_USAGE_PAGE:
+          globals.usagePage = udata;
+          break;
+        case GLOBAL_LOGICAL_MIN:
+          globals.logicalMin = sdata;
+          break;
+        case GLOBAL_LOGICAL_MAX:
+          globals.logicalMax = sdata;
+          globals.logicalMaxUnsigned = udata;
+          break;
+        case GLOBAL_REPORT_SIZE:
+          globals.reportSize = udata;
+          break;
+        case GLOBAL_REPORT_COUNT:
+          globals.reportCount = udata;
+          break;
+        case GLOBAL_REPORT_ID:
+          globals.reportId = udata;
+          pOffset = findOffset(offsets, offsetCount, globals.reportId);
+          break;
+        case GLOBAL_PUSH:
+          if (globalStackDepth == maxGlobalStackDepth) {
+            BLEGC_LOGE("Report map pushes more than %zu global item states", maxGlobalStackDepth);
+            return false;
+          }
+          globalStack[globalStackDepth++] = globals;
+          break;
+        case GLOBAL_POP:
+          if (globalStackDepth == 0) {
+            BLEGC_LOGE("Report map pops more global item states than it pushes");
+            return false;
+          }
+          globals = globalStack[--globalStackDepth];
+          pOffset = findOffset(offsets, offsetCount, globals.reportId);
+          break;
+        default:
+          break;
+      }
+      continue;
+    }
+
+    if (type == ITEM_TYPE_LOCAL) {
+      // a 4-byte usage carries its own usage page
+      const uint32_t usage = size == 4 ? udata : static_cast<uint32_t>(globals.usagePage) << 16 | udata;
+      switch (tag) {
+        case LOCAL_USAGE:
+          if (usageCount < maxLocalUsages) {
+            usages[usageCount++] = usage;
+          }
+          break;
+        case LOCAL_USAGE_MIN:
+          usageMin = usage;
+          break;
+        case LOCAL_USAGE_MAX:
+          usageMax = usage;
+          break;
+        default:
+          break;
+      }
+      continue;
+    }
+
+    if (type != ITEM_TYPE_MAIN) {
+      continue;
+    }
+
+    if (tag == MAIN_INPUT && pOffset) {
+      const bool isVariable = (udata & (INPUT_CONSTANT | INPUT_VARIABLE)) == INPUT_VARIABLE;
+      const bool isReportDecoded = !reportChosen || globals.reportId == _reportId;
+      const int32_t logicalMin = globals.logicalMin;
+      const uint32_t reportSize = globals.reportSize;
+      const uint32_t reportCount = globals.reportCount;
+      // some descriptors declare an unsigned maximum that does not fit in the size of the item, e.g. 0xffff in 2 bytes
+      const int32_t max = logicalMin >= 0 && globals.logicalMax < logicalMin
+                              ? static_cast<int32_t>(globals.logicalMaxUnsigned)
+                              : globals.logicalMax;
+      // fields past the declared usages are padding, the last usage is not repeated for them
+      const uint32_t rangeLen = usageMax != 0 && usageMax >= usageMin ? usageMax - usageMin + 1 : 0;
+
+      for (uint32_t i = 0; isVariable && isReportDecoded && i < reportCount && reportSize > 0 && reportSize <= 32;
+           i++) {
+        uint32_t usage;
+        if (i < usageCount) {
+          usage = usages[i];
+        } else if (i - usageCount < rangeLen) {
+          usage = usageMin + (i - usageCount);
+        } else {
+          break;
+        }
+
+        Step step{};
+        if (!mapUsage(usage, step.target, step.index)) {
+          continue;
+        }
+
+        step.bitOffset = pOffset->bitOffset + i * reportSize;
+        step.bitSize = reportSize;
+        step.isSigned = logicalMin < 0;
+        step.logicalMin = logicalMin;
+        step.logicalMax = max;
+
+        const int64_t range = static_cast<int64_t>(max) - logicalMin;
+        if (step.target == Target::Axis || step.target == Target::RestAxis) {
+          if (range <= 0 || reportSize > 16) {
+            continue;
+          }
+          // rounding up makes the logical maximum reach the end of the output range, decoding clamps any excess
+          const int64_t outRange = step.target == Target::Axis ? axisOutRange : restAxisOutRange;
+          step.scale = ((outRange << 16) + range - 1) / range;
+        } else if (step.target == Target::Buttons) {
+          step.bitSize = 1;
+        } else if (step.target == Target::Hat && range <= 0) {
+          continue;
+        }
+
+        if (!reportChosen) {
+          reportChosen = true;
+          _reportId = globals.reportId;
+        }
+        if (!_addStep(step)) {
+          break;
+        }
+      }
+
+      pOffset->bitOffset += reportSize * reportCount;
+    }
+
+    if (tag == MAIN_INPUT || tag == MAIN_OUTPUT || tag == MAIN_FEATURE || tag == MAIN_COLLECTION ||
+        tag == MAIN_END_COLLECTION) {
+      usageCount = 0;
+      usageMin = 0;
+      usageMax = 0;
+    }
+  }
+
+  for (size_t i = 0; i < _stepCount; i++) {
+    const size_t endLen = (_steps[i].bitOffset + _steps[i].bitSize + 7) / 8;
+    _minReportLen = endLen > _minReportLen ? endLen : _minReportLen;
+  }
+
+  BLEGC_LOGD("Decode plan compiled, report id: %d, steps: %zu, min report length: %zu", _reportId, _stepCount,
+             _minReportLen);
+  return _stepCount > 0;
+}
+
+bool HIDDecodePlan::_addStep(const Step& step) {
+  // buttons are usually declared as a run of single bits, which decodes as a single step
+  if (step.target == Target::Buttons && _stepCount > 0) {
+    auto& last = _steps[_stepCount - 1];
+    if (last.target == Target::Buttons && last.bitOffset + last.bitSize == step.bitOffset &&
+        last.index + last.bitSize == step.index) {
+      last.bitSize++;
+      return true;
+    }
+  }
+
+  if (_stepCount == CONFIG_BT_BLEGC_HID_MAX_DECODE_STEPS) {
+    BLEGC_LOGW("Decode plan full, remaining controls are ignored");
+    return false;
+  }
+
+  _steps[_stepCount++] = step;
+  return true;
+}
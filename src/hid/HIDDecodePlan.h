@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "config.h"
+
+/**
+ * @brief Flat decode plan of the gamepad controls of a HID input report, compiled from a HID report descriptor.
+ *
+ * Parsing walks the report descriptor once per connection. Decoding a report only executes the resulting steps, each of
+ * which extracts one bit field and stores it in a button mask, an axis or the hat switch.
+ */
+class HIDDecodePlan {
+ public:
+  enum class Target : uint8_t {
+    /// @brief Consecutive buttons, one bit each, stored starting at the button with the step's index.
+    Buttons,
+    /// @brief Centered axis, scaled to -32767..32767.
+    Axis,
+    /// @brief Axis starting at rest, such as a trigger, scaled to 0..32767.
+    RestAxis,
+    /// @brief Hat switch, converted to 0 (centered) or a direction from 1 (up) to 8 (up-left), clockwise.
+    Hat,
+  };
+
+  struct Step {
+    uint16_t bitOffset;
+    uint8_t bitSize;
+    Target target;
+    uint8_t index;
+    bool isSigned;
+    int32_t logicalMin;
+    int32_t logicalMax;
+    /// @brief Multiplier, in units of 1/65536, mapping the logical range onto the output range of the target.
+    int64_t scale;
+  };
+
+  /// @brief Maximum number of buttons a plan can decode.
+  static constexpr uint8_t maxButtons = 16;
+
+  /// @brief Number of axes a plan can decode, see `HIDGamepadState::Axis` for their order.
+  static constexpr uint8_t axisCount = 8;
+
+  HIDDecodePlan();
+
+  bool parse(const uint8_t reportMap[], size_t reportMapLen);
+
+  /// @brief Report ID of the decoded input report, or 0 if the report descriptor does not use report IDs.
+  uint8_t reportId() const { return _reportId; }
+
+  /// @brief Minimal length, in bytes, of a report that can be decoded with this plan.
+  size_t minReportLen() const { return _minReportLen; }
+
+  const Step* steps() const { return _steps; }
+  size_t stepCount() const { return _stepCount; }
+
+ private:
+  bool _addStep(const Step& step);
+
+  Step _steps[CONFIG_BT_BLEGC_HID_MAX_DECODE_STEPS];
+  size_t _stepCount;
+  size_t _minReportLen;
+  uint8_t _reportId;
+};
@@ -0,0 +1,75 @@
+#include "HIDGamepadController.h"
+
+#include <NimBLEDevice.h>
+#include "BLEValueReceiver.h"
+#include "logger.h"
+#include "utils.h"
+
+#define REPORT_TYPE_INPUT 0x01
+
+using namespace blegc;
+
+HIDGamepadController::HIDGamepadController() : _plan() {
+  setActivityCallback(reportActivity, static_cast<BLEAbstractController*>(this));
+}
+
+BLEAdvMatchRules HIDGamepadController::getMatchRules() const {
+  static constexpr BLEAdvMatchRule rules[] = {
+      BLEAdvMatchRule().withAppearance(gamepadAppearance),
+      BLEAdvMatchRule().withAppearance(joystickAppearance),
+  };
+  return {rules, sizeof(rules) / sizeof(rules[0])};
+}
+
+bool HIDGamepadController::init() {
+  if (!_plan.parse(_reportMap.data(), _reportMap.size())) {
+    BLEGC_LOGE("No gamepad controls found in the report map");
+    return false;
+  }
+
+  HIDGamepadState initialValue;
+  initialValue.plan = &_plan;
+  return BLEValueReceiver::init(_findInputReportChar(), initialValue);
+}
+
+bool HIDGamepadController::deinit() {
+  BLEValueReceiver::deinit();
+  return true;
+}
+
+NimBLERemoteCharacteristic* HIDGamepadController::_findInputReportChar() const {
+  if (_plan.reportId() == 0) {
+    return findNotifiableCharacteristic(_pClient, hidSvcUUID, inputReportChrUUID);
+  }
+
+  auto* pService = _pClient->getService(hidSvcUUID);
+  if (!pService) {
+    BLEGC_LOGE("Service not found, service uuid: %s", std::string(NimBLEUUID(hidSvcUUID)).c_str());
+    return nullptr;
+  }
+
+  // discovers only the input report characteristics, unless they have been discovered already, the result is unused
+  // because a service can have several of them
+  pService->getCharacteristic(inputReportChrUUID);
+
+  // input reports are told apart by the report reference descriptor, holding the report id and the report type
+  for (auto* pChar : pService->getCharacteristics(false)) {
+    if (pChar->getUUID() != inputReportChrUUID || !pChar->canNotify()) {
+      continue;
+    }
+
+    auto* pDsc = pChar->getDescriptor(reportReferenceDscUUID);
+    if (!pDsc) {
+      continue;
+    }
+
+    const auto attValue = pDsc->readValue();
+    if (attValue.length() >= 2 && attValue.data()[0] == _plan.reportId() &&
+        attValue.data()[1] == REPORT_TYPE_INPUT) {
+      return pChar;
+    }
+  }
+
+  BLEGC_LOGE("Input report not found, report id: %d", _plan.reportId());
+  return nullptr;
+}
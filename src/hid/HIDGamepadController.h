@@ -0,0 +1,30 @@
+#pragma once
+
+#include <NimBLEAddress.h>
+#include "BLEBaseController.h"
+#include "BLEValueReceiver.h"
+#include "HIDDecodePlan.h"
+#include "HIDGamepadState.h"
+
+class HIDGamepadController;
+
+/**
+ * @brief Controller for gamepads that follow the HID over GATT profile. Reports are decoded according to the gamepad's
+ * HID report descriptor, so no gamepad-specific decoder is needed.
+ */
+class HIDGamepadController final : public BLEBaseController<HIDGamepadController>,
+                                   public BLEValueReceiver<HIDGamepadState> {
+ public:
+  HIDGamepadController();
+  ~HIDGamepadController() override = default;
+
+ protected:
+  BLEAdvMatchRules getMatchRules() const override;
+  bool init() override;
+  bool deinit() override;
+
+ private:
+  NimBLERemoteCharacteristic* _findInputReportChar() const;
+
+  HIDDecodePlan _plan;
+};
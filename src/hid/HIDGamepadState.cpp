@@ -0,0 +1,87 @@
+#include "HIDGamepadState.h"
+
+#include <cstring>
+
+constexpr int32_t axisOutMin = -32767;
+constexpr int32_t axisOutMax = 32767;
+constexpr uint8_t hatDirections = 8;
+
+// reads a little-endian field of up to 32 bits, the plan guarantees that it lies within the report
+static uint32_t extractBits(const uint8_t data[], const uint16_t bitOffset, const uint8_t bitSize) {
+  const size_t first = bitOffset >> 3;
+  const size_t last = (bitOffset + bitSize - 1) >> 3;
+
+  uint64_t word = 0;
+  for (size_t i = last + 1; i-- > first;) {
+    word = word << 8 | data[i];
+  }
+  word >>= bitOffset & 7;
+  return bitSize < 32 ? static_cast<uint32_t>(word & ((1u << bitSize) - 1)) : static_cast<uint32_t>(word);
+}
+
+static int32_t clamp(const int32_t val, const int32_t lo, const int32_t hi) {
+  return val < lo ? lo : val > hi ? hi : val;
+}
+
+BLEDecodeResult HIDGamepadState::decode(uint8_t data[], size_t dataLen, uint32_t& changedFields) {
+  changedFields = 0;
+  if (!plan) {
+    return BLEDecodeResult::NotSupported;
+  }
+
+  if (dataLen < plan->minReportLen()) {
+    return BLEDecodeResult::InvalidReport;
+  }
+
+  Raw val{};
+  const auto* pSteps = plan->steps();
+  for (size_t i = 0, count = plan->stepCount(); i < count; i++) {
+    const auto& step = pSteps[i];
+    const auto bits = extractBits(data, step.bitOffset, step.bitSize);
+    if (step.target == HIDDecodePlan::Target::Buttons) {
+      val.buttons |= bits << step.index;
+      continue;
+    }
+
+    // sign-extend fields with a negative logical minimum
+    const int32_t signShift = 32 - step.bitSize;
+    const int32_t logical = step.isSigned && signShift > 0 ? static_cast<int32_t>(bits << signShift) >> signShift
+                                                           : static_cast<int32_t>(bits);
+    const int64_t offset = static_cast<int64_t>(logical) - step.logicalMin;
+
+    switch (step.target) {
+      case HIDDecodePlan::Target::Axis:
+        val.axes[step.index] = clamp(static_cast<int32_t>((offset * step.scale) >> 16) + axisOutMin, axisOutMin,
+                                     axisOutMax);
+        break;
+      case HIDDecodePlan::Target::RestAxis:
+        val.axes[step.index] = clamp(static_cast<int32_t>((offset * step.scale) >> 16), 0, axisOutMax);
+        break;
+      case HIDDecodePlan::Target::Hat:
+        // values outside the logical range mean the hat is centered
+        if (logical >= step.logicalMin && logical <= step.logicalMax) {
+          const int64_t positions = static_cast<int64_t>(step.logicalMax) - step.logicalMin + 1;
+          val.hat = static_cast<uint8_t>(offset * hatDirections / positions + 1);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  changedFields = (this->raw.buttons ^ val.buttons) & Buttons;
+  for (uint8_t i = 0; i < HIDDecodePlan::axisCount; i++) {
+    changedFields |= this->raw.axes[i] != val.axes[i] ? static_cast<uint32_t>(AxisX) << i : static_cast<uint32_t>(0);
+  }
+  changedFields |= this->raw.hat != val.hat ? static_cast<uint32_t>(HatSwitch) : static_cast<uint32_t>(0);
+  this->raw = val;
+
+  return BLEDecodeResult::Success;
+}
+
+bool HIDGamepadState::operator==(const HIDGamepadState& rhs) const {
+  return this->controllerAddress == rhs.controllerAddress && memcmp(&this->raw, &rhs.raw, sizeof(Raw)) == 0;
+}
+bool HIDGamepadState::operator!=(const HIDGamepadState& rhs) const {
+  return !(*this == rhs);
+}
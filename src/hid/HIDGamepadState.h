@@ -0,0 +1,87 @@
+#pragma once
+
+#include <type_traits>
+#include "BLEBaseValue.h"
+#include "HIDDecodePlan.h"
+
+struct HIDGamepadState final : BLEBaseValue {
+  /// @brief Axes of the gamepad, in the order of their HID usages.
+  enum Axis : uint8_t {
+    X = 0,
+    Y = 1,
+    Z = 2,
+    Rx = 3,
+    Ry = 4,
+    Rz = 5,
+    Accelerator = 6,
+    Brake = 7,
+  };
+
+  /// @brief Bits of the change mask reported by `decode()` and the value changed callback, one bit per field. Bits 0 to
+  /// 15 are buttons 1 to 16, the same as in `Raw::buttons`.
+  enum Field : uint32_t {
+    Buttons = 0xffff,
+    AxisX = 1u << 16,
+    AxisY = 1u << 17,
+    AxisZ = 1u << 18,
+    AxisRx = 1u << 19,
+    AxisRy = 1u << 20,
+    AxisRz = 1u << 21,
+    AxisAccelerator = 1u << 22,
+    AxisBrake = 1u << 23,
+    HatSwitch = 1u << 24,
+  };
+
+  /// @brief Controls decoded from the report, scaled to fixed ranges independent of the gamepad.
+  struct Raw {
+    /// @brief Pressed buttons, bit 0 is button 1.
+    uint32_t buttons;
+
+    /// @brief Axis values, indexed by `Axis`. Centered axes take values between -32767 and 32767, positive X is right
+    /// and positive Y is down. `Accelerator` and `Brake` take values between 0 and 32767.
+    int16_t axes[HIDDecodePlan::axisCount];
+
+    /// @brief Hat switch direction, 0 when centered, otherwise from 1 (up) to 8 (up-left), clockwise.
+    uint8_t hat;
+    uint8_t reserved[3];
+  };
+  static_assert(sizeof(Raw) == 24, "Raw must not contain padding");
+  static_assert(std::is_trivially_copy_assignable<Raw>::value, "Raw is copied by lock-free reads");
+
+  static constexpr int16_t q15Max = INT16_MAX;
+
+  /// @brief Controls in the decoded form, all other accessors are derived from it.
+  Raw raw{};
+
+  /// @brief Plan used to decode the reports, set by the controller when it connects.
+  const HIDDecodePlan* plan{nullptr};
+
+  /// @brief Axis value. Takes values between -1.0 and 1.0 for centered axes, and between 0.0 and 1.0 for `Accelerator`
+  /// and `Brake`. Axes not reported by the gamepad yield 0.0.
+  float axis(const Axis a) const { return axisScale * static_cast<float>(raw.axes[a]); }
+
+  /// @brief Same as `axis()`, as a fixed-point number between -32767 and 32767. Does not use floating-point math.
+  int16_t axisQ15(const Axis a) const { return raw.axes[a]; }
+
+  /// @brief Button with the given number, starting at 1, as numbered by the gamepad's report descriptor.
+  bool button(const uint8_t number) const {
+    return number >= 1 && number <= HIDDecodePlan::maxButtons && raw.buttons & 1u << (number - 1);
+  }
+
+  /// @brief Hat switch direction, 0 when centered, otherwise from 1 (up) to 8 (up-left), clockwise.
+  uint8_t hat() const { return raw.hat; }
+
+  /**
+   * @brief Decodes the report into this value, using the decode plan.
+   * @param data Report data.
+   * @param dataLen Length of the report data.
+   * @param[out] changedFields Set to the mask of `Field` bits of the fields whose value has changed.
+   * @return Result of decoding.
+   */
+  BLEDecodeResult decode(uint8_t data[], size_t dataLen, uint32_t& changedFields);
+  bool operator==(const HIDGamepadState& rhs) const;
+  bool operator!=(const HIDGamepadState& rhs) const;
+
+ private:
+  static constexpr float axisScale = 1.0f / q15Max;
+};
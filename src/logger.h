@@ -34,6 +34,9 @@ void logBufferBin(esp_log_level_t level, const char* tag, const uint8_t *buf, st
 #define BLEGC_LOGW(format, ...) ESP_LOG_LEVEL(ESP_LOG_WARN, BLEGC_LOG_TAG, format, ## __VA_ARGS__)
 #define BLEGC_LOGE(format, ...) ESP_LOG_LEVEL(ESP_LOG_ERROR, BLEGC_LOG_TAG, format, ## __VA_ARGS__)
 
+// arguments of the log macros are evaluated even when the level is disabled, guard the ones that allocate
+#define BLEGC_LOG_ENABLED(level) (esp_log_level_get(BLEGC_LOG_TAG) >= (level))
+
 #if CONFIG_BT_BLEGC_LOG_BUFFER_ENABLED
 #define BLEGC_LOGD_BUFFER_HEX(buf, bufLen) blegc::logBufferHex(ESP_LOG_DEBUG, BLEGC_LOG_TAG, buf, bufLen)
 #define BLEGC_LOGD_BUFFER_BIN(buf, bufLen) blegc::logBufferBin(ESP_LOG_DEBUG, BLEGC_LOG_TAG, buf, bufLen)
@@ -39,10 +39,15 @@ static const std::string settingsCharUUID = "100f6c34-1735-4313-b402-38567131e5f
 
 using namespace blegc;
 
-SteamController::SteamController() {}
+SteamController::SteamController() {
+  setActivityCallback(reportActivity, static_cast<BLEAbstractController*>(this));
+}
 
-bool SteamController::isSupported(const NimBLEAdvertisedDevice* pAdvertisedDevice) {
-  return pAdvertisedDevice->haveName() && pAdvertisedDevice->getName() == "SteamController";
+BLEAdvMatchRules SteamController::getMatchRules() const {
+  static constexpr BLEAdvMatchRule rules[] = {
+      BLEAdvMatchRule().withCompleteName("SteamController"),
+  };
+  return {rules, sizeof(rules) / sizeof(rules[0])};
 }
 
 bool SteamController::init() {
@@ -65,5 +70,6 @@ bool SteamController::init() {
 }
 
 bool SteamController::deinit() {
+  BLEValueReceiver::deinit();
   return true;
 }
@@ -14,7 +14,7 @@ class SteamController final : public BLEBaseController<SteamController>, public
   ~SteamController() override = default;
 
  protected:
-  bool isSupported(const NimBLEAdvertisedDevice* pAdvertisedDevice) override;
+  BLEAdvMatchRules getMatchRules() const override;
   bool init() override;
   bool deinit() override;
 };
@@ -1,7 +1,7 @@
 #include "SteamControlsState.h"
 
 #include <NimBLEDevice.h>
-#include <bitset>
+#include <cstring>
 #include "logger.h"
 
 // Sources
@@ -17,6 +17,7 @@
 #define CONTAINS_GYRO_DATA 0x1000
 
 constexpr size_t controlsDataLen = 19;
+constexpr uint8_t byte2ButtonsMask = 0x5f;
 
 inline uint16_t make_uint16(const uint8_t lsb, const uint8_t msb) {
   uint16_t val = msb;
@@ -32,19 +33,30 @@ inline int16_t make_int16(const uint8_t lsb, const uint8_t msb) {
   return val;
 }
 
-inline bool decodeButton(uint8_t byte, int bit) {
-  return byte & 1 << bit;
+constexpr size_t headerLen = 3;
+constexpr size_t buttonsDataLen = 3;
+constexpr size_t triggersDataLen = 2;
+constexpr size_t thumbstickDataLen = 4;
+constexpr size_t padDataLen = 4;
+
+// length of the report with all the sections announced in the content info
+inline size_t requiredDataLen(const uint16_t contentInfo) {
+  size_t len = headerLen;
+  len += contentInfo & CONTAINS_BUTTONS_DATA ? buttonsDataLen : 0;
+  len += contentInfo & CONTAINS_TRIGGERS_DATA ? triggersDataLen : 0;
+  len += contentInfo & CONTAINS_THUMBSTICK_DATA ? thumbstickDataLen : 0;
+  len += contentInfo & CONTAINS_LEFT_PAD_DATA ? padDataLen : 0;
+  len += contentInfo & CONTAINS_RIGHT_PAD_DATA ? padDataLen : 0;
+  return len;
 }
 
-inline float decodePad(const uint8_t lsb, const uint8_t msb) {
-  return static_cast<float>(make_int16(lsb, msb)) / INT16_MAX;
+template <typename V>
+inline uint32_t changedBit(const V oldVal, const V newVal, const uint32_t fieldBit) {
+  return oldVal != newVal ? fieldBit : 0;
 }
 
-inline float decodeTrigger(const uint8_t b) {
-  return static_cast<float>(b) / UINT8_MAX;
-}
-
-BLEDecodeResult SteamControlsState::decode(uint8_t data[], size_t dataLen) {
+BLEDecodeResult SteamControlsState::decode(uint8_t data[], size_t dataLen, uint32_t& changedFields) {
+  changedFields = 0;
   if (dataLen != controlsDataLen) {
     return BLEDecodeResult::InvalidReport;
   }
@@ -53,107 +65,101 @@ BLEDecodeResult SteamControlsState::decode(uint8_t data[], size_t dataLen) {
     return BLEDecodeResult::NotSupported;
   }
 
-  if (data[1] & 0x0f != REPORT_TYPE_INPUT) {
+  if ((data[1] & 0x0f) != REPORT_TYPE_INPUT) {
     return BLEDecodeResult::NotSupported;
   }
 
+  // with every section announced, the right pad section would end one byte past the report. The controller sends its
+  // sections spread over several reports, so such a report is not decoded at all rather than decoded partially.
   const auto contentInfo = make_uint16(data[1], data[2]);
+  if (requiredDataLen(contentInfo) > dataLen) {
+    BLEGC_LOGV("Report sections exceed the report length, content info: 0x%04x", contentInfo);
+    return BLEDecodeResult::NotSupported;
+  }
 
-  auto offset = 3;
+  // sections that are not announced keep their previous values
+  Raw val = this->raw;
+  size_t offset = headerLen;
   if (contentInfo & CONTAINS_BUTTONS_DATA) {
-    const uint8_t byte0 = data[offset];
-    this->rightTriggerButton = decodeButton(byte0, 0);
-    this->leftTriggerButton = decodeButton(byte0, 1);
-    this->rightBumper = decodeButton(byte0, 2);
-    this->leftBumper = decodeButton(byte0, 3);
-    this->buttonY = decodeButton(byte0, 4);
-    this->buttonB = decodeButton(byte0, 5);
-    this->buttonX = decodeButton(byte0, 6);
-    this->buttonA = decodeButton(byte0, 7);
-
-    const uint8_t byte1 = data[offset + 1];
-
-    this->dpadUp = decodeButton(byte1, 0);
-    this->dpadRight = decodeButton(byte1, 1);
-    this->dpadLeft = decodeButton(byte1, 2);
-    this->dpadDown = decodeButton(byte1, 3);
-    this->selectButton = decodeButton(byte1, 4);
-    this->steamButton = decodeButton(byte1, 5);
-    this->startButton = decodeButton(byte1, 6);
-    this->leftGripButton = decodeButton(byte1, 7);
-
-    const uint8_t byte2 = data[offset + 2];
-    this->rightGripButton = decodeButton(byte2, 0);
-    this->leftPadClick = decodeButton(byte2, 1);
-    this->rightPadClick = decodeButton(byte2, 2);
-    this->leftPadTouch = decodeButton(byte2, 3);
-    this->rightPadTouch = decodeButton(byte2, 4);
-    this->stickButton = decodeButton(byte2, 6);
-    offset += 3;
+    // button bits in the three bytes are laid out the same way as in the button mask
+    val.buttons = data[offset] | data[offset + 1] << 8 | (data[offset + 2] & byte2ButtonsMask) << 16;
+    offset += buttonsDataLen;
   }
 
   if (contentInfo & CONTAINS_TRIGGERS_DATA) {
-    this->leftTrigger = decodeTrigger(data[offset]);
-    this->rightTrigger = decodeTrigger(data[offset + 1]);
-    offset += 2;
+    val.leftTrigger = data[offset];
+    val.rightTrigger = data[offset + 1];
+    offset += triggersDataLen;
   }
 
   if (contentInfo & CONTAINS_THUMBSTICK_DATA) {
-    this->stickX = decodePad(data[offset], data[offset + 1]);
-    this->stickY = decodePad(data[offset + 2], data[offset + 3]);
-    offset += 4;
+    val.stickX = make_int16(data[offset], data[offset + 1]);
+    val.stickY = make_int16(data[offset + 2], data[offset + 3]);
+    offset += thumbstickDataLen;
   }
 
   if (contentInfo & CONTAINS_LEFT_PAD_DATA) {
-    this->leftPadX = decodePad(data[offset], data[offset + 1]);
-    this->leftPadY = decodePad(data[offset + 2], data[offset + 3]);
-    offset += 4;
+    val.leftPadX = make_int16(data[offset], data[offset + 1]);
+    val.leftPadY = make_int16(data[offset + 2], data[offset + 3]);
+    offset += padDataLen;
   }
 
   if (contentInfo & CONTAINS_RIGHT_PAD_DATA) {
-    this->rightPadX = decodePad(data[offset], data[offset + 1]);
-    this->rightPadY = decodePad(data[offset + 2], data[offset + 3]);
-    offset += 4;
+    val.rightPadX = make_int16(data[offset], data[offset + 1]);
+    val.rightPadY = make_int16(data[offset + 2], data[offset + 3]);
+    offset += padDataLen;
   }
 
+  changedFields = (this->raw.buttons ^ val.buttons) | changedBit(this->raw.stickX, val.stickX, StickX) |
+                  changedBit(this->raw.stickY, val.stickY, StickY) |
+                  changedBit(this->raw.leftPadX, val.leftPadX, LeftPadX) |
+                  changedBit(this->raw.leftPadY, val.leftPadY, LeftPadY) |
+                  changedBit(this->raw.rightPadX, val.rightPadX, RightPadX) |
+                  changedBit(this->raw.rightPadY, val.rightPadY, RightPadY) |
+                  changedBit(this->raw.leftTrigger, val.leftTrigger, LeftTrigger) |
+                  changedBit(this->raw.rightTrigger, val.rightTrigger, RightTrigger);
+  this->raw = val;
+  if (changedFields == 0) {
+    return BLEDecodeResult::Success;
+  }
+
+  this->stickX = axis(val.stickX);
+  this->stickY = axis(val.stickY);
+  this->leftPadX = axis(val.leftPadX);
+  this->leftPadY = axis(val.leftPadY);
+  this->rightPadX = axis(val.rightPadX);
+  this->rightPadY = axis(val.rightPadY);
+  this->leftTrigger = trigger(val.leftTrigger);
+  this->rightTrigger = trigger(val.rightTrigger);
+
+  this->stickButton = val.buttons & StickButton;
+  this->leftPadClick = val.buttons & LeftPadClick;
+  this->rightPadClick = val.buttons & RightPadClick;
+  this->leftPadTouch = val.buttons & LeftPadTouch;
+  this->rightPadTouch = val.buttons & RightPadTouch;
+  this->dpadUp = val.buttons & DpadUp;
+  this->dpadDown = val.buttons & DpadDown;
+  this->dpadLeft = val.buttons & DpadLeft;
+  this->dpadRight = val.buttons & DpadRight;
+  this->buttonA = val.buttons & ButtonA;
+  this->buttonB = val.buttons & ButtonB;
+  this->buttonX = val.buttons & ButtonX;
+  this->buttonY = val.buttons & ButtonY;
+  this->leftBumper = val.buttons & LeftBumper;
+  this->rightBumper = val.buttons & RightBumper;
+  this->leftTriggerButton = val.buttons & LeftTriggerButton;
+  this->rightTriggerButton = val.buttons & RightTriggerButton;
+  this->leftGripButton = val.buttons & LeftGripButton;
+  this->rightGripButton = val.buttons & RightGripButton;
+  this->startButton = val.buttons & StartButton;
+  this->selectButton = val.buttons & SelectButton;
+  this->steamButton = val.buttons & SteamButton;
+
   return BLEDecodeResult::Success;
 }
 
 bool SteamControlsState::operator==(const SteamControlsState& rhs) const {
-  // clang-format off
-  return
-    this->controllerAddress == rhs.controllerAddress &&
-    this->stickX == rhs.stickX &&
-    this->stickY == rhs.stickY &&
-    this->stickButton == rhs.stickButton &&
-    this->leftPadX == rhs.leftPadX &&
-    this->leftPadY == rhs.leftPadY &&
-    this->rightPadX == rhs.rightPadX &&
-    this->rightPadY == rhs.rightPadY &&
-    this->leftPadClick == rhs.leftPadClick &&
-    this->rightPadClick == rhs.rightPadClick &&
-    this->leftPadTouch == rhs.leftPadTouch &&
-    this->rightPadTouch == rhs.rightPadTouch &&
-    this->dpadUp == rhs.dpadUp &&
-    this->dpadDown == rhs.dpadDown &&
-    this->dpadLeft == rhs.dpadLeft &&
-    this->dpadRight == rhs.dpadRight &&
-    this->buttonA == rhs.buttonA &&
-    this->buttonB == rhs.buttonB &&
-    this->buttonX == rhs.buttonX &&
-    this->buttonY == rhs.buttonY &&
-    this->leftBumper == rhs.leftBumper &&
-    this->rightBumper == rhs.rightBumper &&
-    this->leftTrigger == rhs.leftTrigger &&
-    this->rightTrigger == rhs.rightTrigger &&
-    this->leftTriggerButton == rhs.leftTriggerButton &&
-    this->rightTriggerButton == rhs.rightTriggerButton &&
-    this->leftGripButton == rhs.leftGripButton &&
-    this->rightGripButton == rhs.rightGripButton &&
-    this->startButton == rhs.startButton &&
-    this->selectButton == rhs.selectButton &&
-    this->steamButton == rhs.steamButton;
-  // clang-format on
+  return this->controllerAddress == rhs.controllerAddress && memcmp(&this->raw, &rhs.raw, sizeof(Raw)) == 0;
 }
 bool SteamControlsState::operator!=(const SteamControlsState& rhs) const {
   return !(*this == rhs);
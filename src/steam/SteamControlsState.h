@@ -1,17 +1,90 @@
 #pragma once
 
+#include <type_traits>
 #include "BLEBaseValue.h"
 
 struct SteamControlsState final : BLEBaseValue {
+  /// @brief Bits of the change mask reported by `decode()` and the value changed callback, one bit per field. Bits of
+  /// the buttons are also their bits in `Raw::buttons`.
+  enum Field : uint32_t {
+    RightTriggerButton = 1u << 0,
+    LeftTriggerButton = 1u << 1,
+    RightBumper = 1u << 2,
+    LeftBumper = 1u << 3,
+    ButtonY = 1u << 4,
+    ButtonB = 1u << 5,
+    ButtonX = 1u << 6,
+    ButtonA = 1u << 7,
+    DpadUp = 1u << 8,
+    DpadRight = 1u << 9,
+    DpadLeft = 1u << 10,
+    DpadDown = 1u << 11,
+    SelectButton = 1u << 12,
+    SteamButton = 1u << 13,
+    StartButton = 1u << 14,
+    LeftGripButton = 1u << 15,
+    RightGripButton = 1u << 16,
+    LeftPadClick = 1u << 17,
+    RightPadClick = 1u << 18,
+    LeftPadTouch = 1u << 19,
+    RightPadTouch = 1u << 20,
+    StickButton = 1u << 22,
+    StickX = 1u << 24,
+    StickY = 1u << 25,
+    LeftPadX = 1u << 26,
+    LeftPadY = 1u << 27,
+    RightPadX = 1u << 28,
+    RightPadY = 1u << 29,
+    LeftTrigger = 1u << 30,
+    RightTrigger = 1u << 31,
+  };
+
+  /// @brief Controls in the form sent by the controller.
+  struct Raw {
+    /// @brief Pressed buttons, a bit set for each pressed button. See `Field` for the bit of each button.
+    uint32_t buttons;
+
+    /// @brief Stick deflection and trackpad touch positions, from -32768 to 32767. Positive X is right, positive Y is
+    /// up.
+    int16_t stickX;
+    int16_t stickY;
+    int16_t leftPadX;
+    int16_t leftPadY;
+    int16_t rightPadX;
+    int16_t rightPadY;
+
+    /// @brief Trigger pressure, from 0 to 255.
+    uint16_t leftTrigger;
+    uint16_t rightTrigger;
+  };
+  static_assert(sizeof(Raw) == 20, "Raw must not contain padding");
+  static_assert(std::is_trivially_copy_assignable<Raw>::value, "Raw is copied by lock-free reads");
+
+  static constexpr int16_t axisMax = INT16_MAX;
+  static constexpr uint16_t triggerMax = UINT8_MAX;
+
+  /// @brief Value returned by the `...Q15()` accessors for a fully deflected stick, an edge of a trackpad or a fully
+  /// pressed trigger.
+  static constexpr int16_t q15Max = INT16_MAX;
+
+  /// @brief Controls in the form sent by the controller, the fields below are derived from it by `decode()`.
+  Raw raw{};
+
   /// @brief Stick deflection along the X-axis. Takes values between -1.0 and 1.0. No deflection should yield 0.0,
   /// unless affected by stick drift. Positive values represent deflection to the right, and negative values to the
   /// left.
   float stickX{0.0f};
 
+  /// @brief Same as `stickX`, as a fixed-point number between -32767 and 32767. Does not use floating-point math.
+  int16_t stickXQ15() const { return axisQ15(raw.stickX); }
+
   /// @brief Stick deflection along the Y-axis. Takes values between -1.0 and 1.0. No deflection should yield 0.0,
   /// unless affected by stick drift. Positive values represent upward deflection, and negative values downward.
   float stickY{0.0f};
 
+  /// @brief Same as `stickY`, as a fixed-point number between -32767 and 32767. Does not use floating-point math.
+  int16_t stickYQ15() const { return axisQ15(raw.stickY); }
+
   /// @brief Button activated when pressing down on the stick, also known as the L3 button.
   bool stickButton{false};
 
@@ -19,18 +92,30 @@ struct SteamControlsState final : BLEBaseValue {
   /// values indicate touches on the right side, and negative values indicate touches on the left side.
   float leftPadX{0.0f};
 
+  /// @brief Same as `leftPadX`, as a fixed-point number between -32767 and 32767. Does not use floating-point math.
+  int16_t leftPadXQ15() const { return axisQ15(raw.leftPadX); }
+
   /// @brief Touch position along the left trackpad's Y-axis. Ranges from -1.0 to 1.0, with 0.0 at the center. Positive
   /// values indicate touches on the upper side, and negative values indicate touches on the lower side.
   float leftPadY{0.0f};
 
+  /// @brief Same as `leftPadY`, as a fixed-point number between -32767 and 32767. Does not use floating-point math.
+  int16_t leftPadYQ15() const { return axisQ15(raw.leftPadY); }
+
   /// @brief Touch position along the right trackpad's X-axis. Ranges from -1.0 to 1.0, with 0.0 at the center.
   /// Positive values indicate touches on the right side, and negative values indicate touches on the left side.
   float rightPadX{0.0f};
 
+  /// @brief Same as `rightPadX`, as a fixed-point number between -32767 and 32767. Does not use floating-point math.
+  int16_t rightPadXQ15() const { return axisQ15(raw.rightPadX); }
+
   /// @brief Touch position along the right trackpad's Y-axis. Ranges from -1.0 to 1.0, with 0.0 at the center.
   /// Positive values indicate touches on the upper side, and negative values indicate touches on the lower side.
   float rightPadY{0.0f};
 
+  /// @brief Same as `rightPadY`, as a fixed-point number between -32767 and 32767. Does not use floating-point math.
+  int16_t rightPadYQ15() const { return axisQ15(raw.rightPadY); }
+
   /// @brief Left trackpad click (press down on the trackpad).
   bool leftPadClick{false};
 
@@ -76,9 +161,15 @@ struct SteamControlsState final : BLEBaseValue {
   /// @brief Pressure level of a left trigger. Takes values between 0.0 and 1.0. No pressure should yield 0.0.
   float leftTrigger{0.0f};
 
+  /// @brief Same as `leftTrigger`, as a fixed-point number between 0 and 32767. Does not use floating-point math.
+  int16_t leftTriggerQ15() const { return triggerQ15(raw.leftTrigger); }
+
   /// @brief Pressure level of a right trigger. Takes values between 0.0 and 1.0. No pressure should yield 0.0.
   float rightTrigger{0.0f};
 
+  /// @brief Same as `rightTrigger`, as a fixed-point number between 0 and 32767. Does not use floating-point math.
+  int16_t rightTriggerQ15() const { return triggerQ15(raw.rightTrigger); }
+
   /// @brief Button activated when the left trigger is fully pressed.
   bool leftTriggerButton{false};
 
@@ -100,7 +191,29 @@ struct SteamControlsState final : BLEBaseValue {
   /// @brief Steam button.
   bool steamButton{false};
 
-  BLEDecodeResult decode(uint8_t data[], size_t dataLen);
+  /**
+   * @brief Decodes the report into this value.
+   * @param data Report data.
+   * @param dataLen Length of the report data.
+   * @param[out] changedFields Set to the mask of `Field` bits of the fields whose value has changed.
+   * @return Result of decoding.
+   */
+  BLEDecodeResult decode(uint8_t data[], size_t dataLen, uint32_t& changedFields);
   bool operator==(const SteamControlsState& rhs) const;
   bool operator!=(const SteamControlsState& rhs) const;
+
+ private:
+  // multiplying by a constant avoids a float division, which is costly on chips without an FPU
+  static constexpr float axisScale = 1.0f / axisMax;
+  static constexpr float triggerScale = 1.0f / triggerMax;
+
+  static float axis(const int16_t val) { return axisScale * static_cast<float>(val); }
+  static float trigger(const uint16_t val) { return triggerScale * static_cast<float>(val); }
+
+  static int16_t axisQ15(const int16_t val) { return val < -q15Max ? -q15Max : val; }
+  // replicating the top bits into the low bits maps 0xff exactly to 0x7fff, larger values would overflow the sign bit
+  static int16_t triggerQ15(const uint16_t val) {
+    const uint16_t clamped = val < triggerMax ? val : triggerMax;
+    return static_cast<int16_t>(clamped << 7 | clamped >> 1);
+  }
 };
@@ -1,6 +1,7 @@
 #include "utils.h"
 
 #include <NimBLEDevice.h>
+#include <cstring>
 #include <string>
 
 #include "logger.h"
@@ -52,6 +53,10 @@ uint8_t getProperties(const NimBLERemoteCharacteristic* pChar) {
 }
 
 std::string remoteCharToStr(const NimBLERemoteCharacteristic* pChar) {
+  if (!pChar) {
+    return "Characteristic: none";
+  }
+
   std::string res = "Characteristic: uuid: " + std::string(pChar->getUUID());
   res += ", handle: ";
   res += std::to_string(pChar->getHandle());
@@ -62,21 +67,6 @@ std::string remoteCharToStr(const NimBLERemoteCharacteristic* pChar) {
   return res;
 }
 
-bool discoverAttributes(NimBLEClient* pClient) {
-  if (!pClient->discoverAttributes()) {
-    BLEGC_LOGE("Failed to discover attributes, address %s", std::string(pClient->getPeerAddress()).c_str());
-    return false;
-  }
-
-  for (auto& pService : pClient->getServices(false)) {
-    BLEGC_LOGD("Discovered %s", remoteSvcToStr(pService).c_str());
-    for (auto& pChar : pService->getCharacteristics(false)) {
-      BLEGC_LOGD("Discovered %s", remoteCharToStr(pChar).c_str());
-    }
-  }
-  return true;
-}
-
 NimBLERemoteCharacteristic* findCharacteristic(NimBLEClient* pClient,
                                                const NimBLEUUID& serviceUUID,
                                                const NimBLEUUID& characteristicUUID,
@@ -96,10 +86,13 @@ NimBLERemoteCharacteristic* findCharacteristic(NimBLEClient* pClient,
 
   unsigned int _idx = idx;
 
-  auto characteristics = pService->getCharacteristics(false);
-  if (characteristics.empty()) {
-    characteristics = pService->getCharacteristics(true);
+  if (!isNull(characteristicUUID)) {
+    // discovers only the characteristics with this uuid, unless they have been discovered already
+    pService->getCharacteristic(characteristicUUID);
+  } else if (pService->getCharacteristics(false).empty()) {
+    pService->getCharacteristics(true);
   }
+  const auto& characteristics = pService->getCharacteristics(false);
 
   for (auto* pChar : characteristics) {
     if (!isNull(characteristicUUID) && characteristicUUID != pChar->getUUID()) {
@@ -146,14 +139,15 @@ NimBLERemoteCharacteristic* findWritableCharacteristic(NimBLEClient* pClient,
   return findCharacteristic(pClient, serviceUUID, characteristicUUID, BLE_GATT_CHR_PROP_WRITE, idx);
 }
 
-void readReportMap(NimBLEClient* pClient, std::vector<uint8_t>* pReportMap) {
+bool readReportMap(NimBLEClient* pClient, std::vector<uint8_t>* pReportMap) {
   auto* pChar = findReadableCharacteristic(pClient, hidSvcUUID, reportMapCharUUID);
   if (!pChar) {
-    return;
+    return false;
   }
 
   const auto attValue = pChar->readValue();
   pReportMap->assign(attValue.begin(), attValue.end());
+  return true;
 }
 
 bool haveShortenedName(const NimBLEAdvertisedDevice* pAdvertisedDevice) {
@@ -164,11 +158,67 @@ std::string getShortenedName(const NimBLEAdvertisedDevice* pAdvertisedDevice) {
   return pAdvertisedDevice->getPayloadByType(BLE_HS_ADV_TYPE_INCOMP_NAME);
 }
 
-uint16_t getManufacturerId(const NimBLEAdvertisedDevice* pAdvertisedDevice) {
-  auto mfgData = pAdvertisedDevice->getManufacturerData();
-  configASSERT(mfgData.size() >= 2);
-  uint16_t manufacturerId = (mfgData[1] << 8) + mfgData[0];  // low endian to native endian conversion
-  return manufacturerId;
+/**
+ * @brief Finds the first field of the given type in the advertisement data, without copying it. The accessors of
+ * NimBLEAdvertisedDevice return fields as std::string, which allocates for every advertisement.
+ * @param pAdvertisedDevice Advertised device.
+ * @param type AD type of the field, e.g. BLE_HS_ADV_TYPE_COMP_NAME.
+ * @param[out] ppData Set to the data of the field, valid as long as the advertised device.
+ * @param[out] pDataLen Set to the length of the data of the field.
+ * @return True if the field was found, false otherwise.
+ */
+bool findAdvField(const NimBLEAdvertisedDevice* pAdvertisedDevice, const uint8_t type, const uint8_t** ppData,
+                  uint8_t* pDataLen) {
+  const auto& payload = pAdvertisedDevice->getPayload();
+  const auto* pPayload = payload.data();
+  const size_t payloadLen = payload.size();
+
+  // each field is a length byte, covering the type byte and the data, followed by the type byte and the data
+  size_t pos = 0;
+  while (pos + 1 < payloadLen) {
+    const uint8_t fieldLen = pPayload[pos];
+    if (fieldLen == 0 || pos + 1 + fieldLen > payloadLen) {
+      break;
+    }
+
+    if (pPayload[pos + 1] == type) {
+      *ppData = &pPayload[pos + 2];
+      *pDataLen = fieldLen - 1;
+      return true;
+    }
+    pos += 1 + fieldLen;
+  }
+
+  return false;
+}
+
+bool advNameEquals(const NimBLEAdvertisedDevice* pAdvertisedDevice, const char* name) {
+  const uint8_t* pData;
+  uint8_t dataLen;
+  return findAdvField(pAdvertisedDevice, BLE_HS_ADV_TYPE_COMP_NAME, &pData, &dataLen) && strlen(name) == dataLen &&
+         memcmp(pData, name, dataLen) == 0;
+}
+
+bool getAdvAppearance(const NimBLEAdvertisedDevice* pAdvertisedDevice, uint16_t* pAppearance) {
+  const uint8_t* pData;
+  uint8_t dataLen;
+  if (!findAdvField(pAdvertisedDevice, BLE_HS_ADV_TYPE_APPEARANCE, &pData, &dataLen) || dataLen < 2) {
+    return false;
+  }
+
+  *pAppearance = pData[1] << 8 | pData[0];  // low endian to native endian conversion
+  return true;
+}
+
+bool getAdvManufacturerId(const NimBLEAdvertisedDevice* pAdvertisedDevice, uint16_t* pManufacturerId) {
+  const uint8_t* pData;
+  uint8_t dataLen;
+  if (!findAdvField(pAdvertisedDevice, BLE_HS_ADV_TYPE_MFG_DATA, &pData, &dataLen) || dataLen < 2) {
+    return false;
+  }
+
+  *pManufacturerId = pData[1] << 8 | pData[0];  // low endian to native endian conversion
+  return true;
 }
 
 }  // namespace blegc
@@ -21,6 +21,7 @@ constexpr uint16_t hidControlCharUUID = 0x2a4c;
 constexpr uint16_t inputReportChrUUID = 0x2a4d;
 constexpr uint16_t batteryLevelCharUUID = 0x2a19;
 constexpr uint16_t batteryLevelDscUUID = 0x2904;
+constexpr uint16_t reportReferenceDscUUID = 0x2908;
 constexpr uint16_t manufacturerNameChrUUID = 0x2a29;
 constexpr uint16_t modelNameChrUUID = 0x2a24;
 constexpr uint16_t serialNumberChrUUID = 0x2a25;
@@ -47,8 +48,6 @@ uint8_t getProperties(const NimBLERemoteCharacteristic* pChar);
 
 std::string remoteCharToStr(const NimBLERemoteCharacteristic* pChar);
 
-bool discoverAttributes(NimBLEClient* pClient);
-
 NimBLERemoteCharacteristic* findCharacteristic(NimBLEClient* pClient,
                                                       const NimBLEUUID& serviceUUID,
                                                       const NimBLEUUID& characteristicUUID,
@@ -70,12 +69,19 @@ NimBLERemoteCharacteristic* findWritableCharacteristic(NimBLEClient* pClient,
                                                               const NimBLEUUID& characteristicUUID,
                                                               uint8_t idx = 0);
 
-void readReportMap(NimBLEClient* pClient, std::vector<uint8_t>* pReportMap);
+bool readReportMap(NimBLEClient* pClient, std::vector<uint8_t>* pReportMap);
 
 bool haveShortenedName(const NimBLEAdvertisedDevice* pAdvertisedDevice);
 
 std::string getShortenedName(const NimBLEAdvertisedDevice* pAdvertisedDevice);
 
-uint16_t getManufacturerId(const NimBLEAdvertisedDevice* pAdvertisedDevice);
+bool findAdvField(const NimBLEAdvertisedDevice* pAdvertisedDevice, uint8_t type, const uint8_t** ppData,
+                  uint8_t* pDataLen);
+
+bool advNameEquals(const NimBLEAdvertisedDevice* pAdvertisedDevice, const char* name);
+
+bool getAdvAppearance(const NimBLEAdvertisedDevice* pAdvertisedDevice, uint16_t* pAppearance);
+
+bool getAdvManufacturerId(const NimBLEAdvertisedDevice* pAdvertisedDevice, uint16_t* pManufacturerId);
 
 }  // namespace blegc
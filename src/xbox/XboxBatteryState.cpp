@@ -5,13 +5,14 @@
 
 constexpr size_t batteryDataLen = 1;
 
-BLEDecodeResult XboxBatteryState::decode(uint8_t data[], size_t dataLen) {
+BLEDecodeResult XboxBatteryState::decode(uint8_t data[], size_t dataLen, uint32_t& changedFields) {
+  changedFields = 0;
   if (dataLen != batteryDataLen) {
     BLEGC_LOGE("Expected %d bytes, was %d bytes", batteryDataLen, dataLen);
     return BLEDecodeResult::InvalidReport;
   }
 
-  this->level = 0.01f * static_cast<float>(data[0]);
+  setField(this->level, 0.01f * static_cast<float>(data[0]), changedFields, Level);
   return BLEDecodeResult::Success;
 }
 bool XboxBatteryState::operator==(const XboxBatteryState& rhs) const {
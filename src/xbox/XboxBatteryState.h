@@ -3,10 +3,15 @@
 #include "BLEBaseValue.h"
 
 struct XboxBatteryState final : BLEBaseValue {
+  /// @brief Bits of the change mask reported by `decode()` and the value changed callback, one bit per field.
+  enum Field : uint32_t {
+    Level = 1u << 0,
+  };
+
   /// @brief Charge level of the controller's battery. Takes values between 0.0 and 1.0. A full battery yields 1.0.
   float level{};
 
-  BLEDecodeResult decode(uint8_t data[], size_t dataLen);
+  BLEDecodeResult decode(uint8_t data[], size_t dataLen, uint32_t& changedFields);
   bool operator==(const XboxBatteryState& rhs) const;
   bool operator!=(const XboxBatteryState& rhs) const;
 };
@@ -8,43 +8,24 @@
 
 using namespace blegc;
 
-XboxController::XboxController() = default;
+XboxController::XboxController() {
+  // battery reports are periodic and do not count as input activity
+  BLEValueReceiver<XboxControlsState>::setActivityCallback(reportActivity, static_cast<BLEAbstractController*>(this));
+}
 XboxController::~XboxController() = default;
 
-bool XboxController::isSupported(const NimBLEAdvertisedDevice* pAdvertisedDevice) {
-  if (pAdvertisedDevice->haveName()) {
-    if (pAdvertisedDevice->getName() == "Xbox Wireless Controller") {
-      return true;
-    }
-
-    BLEGC_LOGD("Name mismatch: %s", pAdvertisedDevice->getName().c_str());
-    return false;
-  }
-
-  if (!pAdvertisedDevice->haveAppearance()) {
-    BLEGC_LOGD("Appearance missing");
-    return false;
-  }
-
-  if (pAdvertisedDevice->getAppearance() != gamepadAppearance) {
-    BLEGC_LOGD("Appearance mismatch: 0x%02x", pAdvertisedDevice->getAppearance());
-    return false;
-  }
-
-  if (!pAdvertisedDevice->haveManufacturerData()) {
-    BLEGC_LOGD("Manufacturer id missing");
-    return false;
-  }
-
-  if (getManufacturerId(pAdvertisedDevice) != microsoftCompanyId) {
-    BLEGC_LOGD("Manufacturer id mismatch: 0x%02x", getManufacturerId(pAdvertisedDevice));
-    return false;
-  }
-
-  return true;
+BLEAdvMatchRules XboxController::getMatchRules() const {
+  // a controller that advertises a name is matched by the name only
+  static constexpr BLEAdvMatchRule rules[] = {
+      BLEAdvMatchRule().withCompleteName("Xbox Wireless Controller"),
+      BLEAdvMatchRule().withoutName().withAppearance(gamepadAppearance).withCompanyId(microsoftCompanyId),
+  };
+  return {rules, sizeof(rules) / sizeof(rules[0])};
 }
 
 bool XboxController::deinit() {
+  BLEValueReceiver<XboxControlsState>::deinit();
+  BLEValueReceiver<XboxBatteryState>::deinit();
   return true;
 }
 
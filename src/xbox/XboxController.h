@@ -19,11 +19,19 @@ class XboxController final : public BLEBaseController<XboxController>,
 
   using BLEValueReceiver<XboxControlsState>::read;
   using BLEValueReceiver<XboxControlsState>::onValueChanged;
+  using BLEValueReceiver<XboxControlsState>::onRawReport;
+  using BLEValueReceiver<XboxControlsState>::setEventBuffer;
+  using BLEValueReceiver<XboxControlsState>::drain;
+  using BLEValueReceiver<XboxControlsState>::readStats;
   using BLEValueReceiver<XboxBatteryState>::read;
   using BLEValueReceiver<XboxBatteryState>::onValueChanged;
+  using BLEValueReceiver<XboxBatteryState>::onRawReport;
+  using BLEValueReceiver<XboxBatteryState>::setEventBuffer;
+  using BLEValueReceiver<XboxBatteryState>::drain;
+  using BLEValueReceiver<XboxBatteryState>::readStats;
 
  protected:
-  bool isSupported(const NimBLEAdvertisedDevice* pAdvertisedDevice) override;
+  BLEAdvMatchRules getMatchRules() const override;
   bool init() override;
   bool deinit() override;
 };
@@ -1,12 +1,28 @@
 #include "XboxControlsState.h"
 
 #include <NimBLEDevice.h>
-#include <bitset>
+#include <cstring>
+#include <iterator>
 #include "logger.h"
 
 constexpr size_t controlsDataLen = 16;
-constexpr uint16_t axisMax = 0xffff;
-constexpr uint16_t triggerMax = 0x3ff;
+constexpr uint8_t byte13ButtonsMask = 0xdb;
+constexpr uint8_t byte14ButtonsMask = 0x7c;
+constexpr uint8_t byte15ButtonsMask = 0x01;
+
+// clang-format off
+constexpr uint32_t dpadButtons[] = {
+  0,
+  XboxControlsState::DpadUp,
+  XboxControlsState::DpadUp | XboxControlsState::DpadRight,
+  XboxControlsState::DpadRight,
+  XboxControlsState::DpadRight | XboxControlsState::DpadDown,
+  XboxControlsState::DpadDown,
+  XboxControlsState::DpadDown | XboxControlsState::DpadLeft,
+  XboxControlsState::DpadLeft,
+  XboxControlsState::DpadLeft | XboxControlsState::DpadUp,
+};
+// clang-format on
 
 inline uint16_t make_uint16(uint8_t lsb, uint8_t msb) {
   uint16_t val = msb;
@@ -15,98 +31,69 @@ inline uint16_t make_uint16(uint8_t lsb, uint8_t msb) {
   return val;
 }
 
-inline float decodeStickX(uint8_t lsb, uint8_t msb) {
-  return 2.0f * static_cast<float>(make_uint16(lsb, msb)) / axisMax - 1.0f;
-}
-
-inline float decodeStickY(uint8_t lsb, uint8_t msb) {
-  return -2.0f * static_cast<float>(make_uint16(lsb, msb)) / axisMax + 1.0f;
-}
-
-inline float decodeTrigger(uint8_t lsb, uint8_t msb) {
-  return 1.0f * static_cast<float>(make_uint16(lsb, msb)) / triggerMax;
+inline uint32_t changedBit(const uint16_t oldVal, const uint16_t newVal, const uint32_t fieldBit) {
+  return oldVal != newVal ? fieldBit : 0;
 }
 
-inline bool decodeButton(uint8_t byte, int bit) {
-  return byte & 1 << bit;
-}
-
-BLEDecodeResult XboxControlsState::decode(uint8_t data[], size_t dataLen) {
+BLEDecodeResult XboxControlsState::decode(uint8_t data[], size_t dataLen, uint32_t& changedFields) {
+  changedFields = 0;
   if (dataLen != controlsDataLen) {
     return BLEDecodeResult::InvalidReport;
   }
 
-  this->leftStickX = decodeStickX(data[0], data[1]);
-  this->leftStickY = decodeStickY(data[2], data[3]);
-  this->rightStickX = decodeStickX(data[4], data[5]);
-  this->rightStickY = decodeStickY(data[6], data[7]);
-  this->leftTrigger = decodeTrigger(data[8], data[9]);
-  this->rightTrigger = decodeTrigger(data[10], data[11]);
+  Raw val{};
+  val.leftStickX = make_uint16(data[0], data[1]);
+  val.leftStickY = make_uint16(data[2], data[3]);
+  val.rightStickX = make_uint16(data[4], data[5]);
+  val.rightStickY = make_uint16(data[6], data[7]);
+  val.leftTrigger = make_uint16(data[8], data[9]);
+  val.rightTrigger = make_uint16(data[10], data[11]);
 
-  // clang-format off
-  this->dpadUp = this->dpadRight = this->dpadDown = this->dpadLeft = false;
-  uint8_t byte12 = data[12];
-  switch (byte12) {
-    case 1: this->dpadUp = true; break;
-    case 2: this->dpadUp = this->dpadRight = true; break;
-    case 3: this->dpadRight = true; break;
-    case 4: this->dpadRight = this->dpadDown = true; break;
-    case 5: this->dpadDown = true; break;
-    case 6: this->dpadDown = this->dpadLeft = true; break;
-    case 7: this->dpadLeft = true; break;
-    case 8: this->dpadLeft = this->dpadUp = true; break;
-    default: break;
-  }
-  // clang-format on
+  // button bits in the bytes 13 - 15 are laid out the same way as in the button mask
+  const uint8_t byte12 = data[12];
+  val.buttons = (data[13] & byte13ButtonsMask) | (data[14] & byte14ButtonsMask) << 8 |
+                (data[15] & byte15ButtonsMask) << 16 | (byte12 < std::size(dpadButtons) ? dpadButtons[byte12] : 0);
 
-  uint8_t byte13 = data[13];
-  this->buttonA = decodeButton(byte13, 0);
-  this->buttonB = decodeButton(byte13, 1);
-  this->buttonX = decodeButton(byte13, 3);
-  this->buttonY = decodeButton(byte13, 4);
-  this->leftBumper = decodeButton(byte13, 6);
-  this->rightBumper = decodeButton(byte13, 7);
+  changedFields = (this->raw.buttons ^ val.buttons) | changedBit(this->raw.leftStickX, val.leftStickX, LeftStickX) |
+                  changedBit(this->raw.leftStickY, val.leftStickY, LeftStickY) |
+                  changedBit(this->raw.rightStickX, val.rightStickX, RightStickX) |
+                  changedBit(this->raw.rightStickY, val.rightStickY, RightStickY) |
+                  changedBit(this->raw.leftTrigger, val.leftTrigger, LeftTrigger) |
+                  changedBit(this->raw.rightTrigger, val.rightTrigger, RightTrigger);
+  this->raw = val;
+  if (changedFields == 0) {
+    return BLEDecodeResult::Success;
+  }
 
-  uint8_t byte14 = data[14];
-  this->viewButton = decodeButton(byte14, 2);
-  this->menuButton = decodeButton(byte14, 3);
-  this->xboxButton = decodeButton(byte14, 4);
-  this->leftStickButton = decodeButton(byte14, 5);
-  this->rightStickButton = decodeButton(byte14, 6);
+  this->leftStickX = stickX(val.leftStickX);
+  this->leftStickY = stickY(val.leftStickY);
+  this->rightStickX = stickX(val.rightStickX);
+  this->rightStickY = stickY(val.rightStickY);
+  this->leftTrigger = trigger(val.leftTrigger);
+  this->rightTrigger = trigger(val.rightTrigger);
 
-  uint8_t byte15 = data[15];
-  this->shareButton = decodeButton(byte15, 0);
+  this->leftStickButton = val.buttons & LeftStickButton;
+  this->rightStickButton = val.buttons & RightStickButton;
+  this->dpadUp = val.buttons & DpadUp;
+  this->dpadDown = val.buttons & DpadDown;
+  this->dpadLeft = val.buttons & DpadLeft;
+  this->dpadRight = val.buttons & DpadRight;
+  this->buttonA = val.buttons & ButtonA;
+  this->buttonB = val.buttons & ButtonB;
+  this->buttonX = val.buttons & ButtonX;
+  this->buttonY = val.buttons & ButtonY;
+  this->leftBumper = val.buttons & LeftBumper;
+  this->rightBumper = val.buttons & RightBumper;
+  this->shareButton = val.buttons & ShareButton;
+  this->menuButton = val.buttons & MenuButton;
+  this->viewButton = val.buttons & ViewButton;
+  this->xboxButton = val.buttons & XboxButton;
 
   return BLEDecodeResult::Success;
 }
 
 bool XboxControlsState::operator==(const XboxControlsState& rhs) const {
-  // clang-format off
-  return
-    this->controllerAddress == rhs.controllerAddress &&
-    this->leftStickX == rhs.leftStickX &&
-    this->leftStickY == rhs.leftStickY &&
-    this->rightStickX == rhs.rightStickX &&
-    this->rightStickY == rhs.rightStickY &&
-    this->leftStickButton == rhs.leftStickButton &&
-    this->rightStickButton == rhs.rightStickButton &&
-    this->dpadUp == rhs.dpadUp &&
-    this->dpadDown == rhs.dpadDown &&
-    this->dpadLeft == rhs.dpadLeft &&
-    this->dpadRight == rhs.dpadRight &&
-    this->buttonA == rhs.buttonA &&
-    this->buttonB == rhs.buttonB &&
-    this->buttonX == rhs.buttonX &&
-    this->buttonY == rhs.buttonY &&
-    this->leftBumper == rhs.leftBumper &&
-    this->rightBumper == rhs.rightBumper &&
-    this->leftTrigger == rhs.leftTrigger &&
-    this->rightTrigger == rhs.rightTrigger &&
-    this->shareButton == rhs.shareButton &&
-    this->menuButton == rhs.menuButton &&
-    this->viewButton == rhs.viewButton &&
-    this->xboxButton == rhs.xboxButton;
-  // clang-format on
+  return this->controllerAddress == rhs.controllerAddress && memcmp(&this->raw, &rhs.raw, sizeof(Raw)) == 0;
 }
 bool XboxControlsState::operator!=(const XboxControlsState& rhs) const {
   return !(*this == rhs);
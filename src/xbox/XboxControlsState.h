@@ -1,26 +1,93 @@
 #pragma once
 
+#include <type_traits>
 #include "BLEBaseValue.h"
 
 struct XboxControlsState final : BLEBaseValue {
+  /// @brief Bits of the change mask reported by `decode()` and the value changed callback, one bit per field. Bits of
+  /// the buttons are also their bits in `Raw::buttons`.
+  enum Field : uint32_t {
+    ButtonA = 1u << 0,
+    ButtonB = 1u << 1,
+    ButtonX = 1u << 3,
+    ButtonY = 1u << 4,
+    LeftBumper = 1u << 6,
+    RightBumper = 1u << 7,
+    ViewButton = 1u << 10,
+    MenuButton = 1u << 11,
+    XboxButton = 1u << 12,
+    LeftStickButton = 1u << 13,
+    RightStickButton = 1u << 14,
+    ShareButton = 1u << 16,
+    DpadUp = 1u << 17,
+    DpadRight = 1u << 18,
+    DpadDown = 1u << 19,
+    DpadLeft = 1u << 20,
+    LeftStickX = 1u << 21,
+    LeftStickY = 1u << 22,
+    RightStickX = 1u << 23,
+    RightStickY = 1u << 24,
+    LeftTrigger = 1u << 25,
+    RightTrigger = 1u << 26,
+  };
+
+  /// @brief Controls in the form sent by the controller.
+  struct Raw {
+    /// @brief Pressed buttons, a bit set for each pressed button. See `Field` for the bit of each button.
+    uint32_t buttons;
+
+    /// @brief Stick deflections, from 0 to 65535. Positive X is right, positive Y is down.
+    uint16_t leftStickX;
+    uint16_t leftStickY;
+    uint16_t rightStickX;
+    uint16_t rightStickY;
+
+    /// @brief Trigger pressure, from 0 to 1023.
+    uint16_t leftTrigger;
+    uint16_t rightTrigger;
+  };
+  static_assert(sizeof(Raw) == 16, "Raw must not contain padding");
+  static_assert(std::is_trivially_copy_assignable<Raw>::value, "Raw is copied by lock-free reads");
+
+  static constexpr uint16_t stickMax = 0xffff;
+  static constexpr uint16_t triggerMax = 0x3ff;
+
+  /// @brief Value returned by the `...Q15()` accessors for a fully deflected stick or a fully pressed trigger.
+  static constexpr int16_t q15Max = INT16_MAX;
+
+  /// @brief Controls in the form sent by the controller, the fields below are derived from it by `decode()`.
+  Raw raw{0, 0x8000, 0x8000, 0x8000, 0x8000, 0, 0};
+
   /// @brief Left stick deflection along the X-axis. Takes values between -1.0 and 1.0. No deflection should yield 0.0,
   /// unless affected by stick drift. Positive values represent deflection to the right, and negative values to the
   /// left.
   float leftStickX{0.0f};
 
+  /// @brief Same as `leftStickX`, as a fixed-point number between -32767 and 32767. Does not use floating-point math.
+  int16_t leftStickXQ15() const { return stickXQ15(raw.leftStickX); }
+
   /// @brief Left stick deflection along the Y-axis. Takes values between -1.0 and 1.0. No deflection should yield 0.0,
   /// unless affected by stick drift. Positive values represent upward deflection, and negative values downward.
   float leftStickY{0.0f};
 
+  /// @brief Same as `leftStickY`, as a fixed-point number between -32767 and 32767. Does not use floating-point math.
+  int16_t leftStickYQ15() const { return stickYQ15(raw.leftStickY); }
+
   /// @brief Right stick deflection along the X-axis. Takes values between -1.0 and 1.0. No deflection should yield 0.0,
   /// unless affected by stick drift. Positive values represent deflection to the right, and negative values to the
   /// left.
   float rightStickX{0.0f};
 
+  /// @brief Same as `rightStickX`, as a fixed-point number between -32767 and 32767. Does not use floating-point math.
+  int16_t rightStickXQ15() const { return stickXQ15(raw.rightStickX); }
+
   /// @brief Right stick deflection along the Y-axis. Takes values between -1.0 and 1.0. No deflection should yield 0.0,
   /// unless affected by stick drift. Positive values represent upward deflection, and negative values downward.
   float rightStickY{0.0f};
 
+  /// @brief Same as `rightStickY`, as a fixed-point number between -32767 and 32767. Does not use floating-point math.
+  int16_t rightStickYQ15() const { return stickYQ15(raw.rightStickY); }
+
   /// @brief Button activated when pressing down on the left stick.
   bool leftStickButton{false};
 
@@ -60,9 +127,15 @@ struct XboxControlsState final : BLEBaseValue {
   /// @brief Pressure level on the left trigger. Takes values between 0.0 and 1.0. No pressure should yield 0.0.
   float leftTrigger{0.0f};
 
+  /// @brief Same as `leftTrigger`, as a fixed-point number between 0 and 32767. Does not use floating-point math.
+  int16_t leftTriggerQ15() const { return triggerQ15(raw.leftTrigger); }
+
   /// @brief Pressure level on the right trigger. Takes values between 0.0 and 1.0. No pressure should yield 0.0.
   float rightTrigger{0.0f};
 
+  /// @brief Same as `rightTrigger`, as a fixed-point number between 0 and 32767. Does not use floating-point math.
+  int16_t rightTriggerQ15() const { return triggerQ15(raw.rightTrigger); }
+
   /// @brief Share button, located below the Xbox button in the center (model 1914).
   bool shareButton{false};
 
@@ -75,7 +148,32 @@ struct XboxControlsState final : BLEBaseValue {
   /// @brief Xbox button.
   bool xboxButton{false};
 
-  BLEDecodeResult decode(uint8_t data[], size_t dataLen);
+  /**
+   * @brief Decodes the report into this value.
+   * @param data Report data.
+   * @param dataLen Length of the report data.
+   * @param[out] changedFields Set to the mask of `Field` bits of the fields whose value has changed.
+   * @return Result of decoding.
+   */
+  BLEDecodeResult decode(uint8_t data[], size_t dataLen, uint32_t& changedFields);
   bool operator==(const XboxControlsState& rhs) const;
   bool operator!=(const XboxControlsState& rhs) const;
+
+ private:
+  // multiplying by a constant avoids a float division, which is costly on chips without an FPU
+  static constexpr float stickScale = 2.0f / stickMax;
+  static constexpr float triggerScale = 1.0f / triggerMax;
+
+  static float stickX(const uint16_t val) { return stickScale * static_cast<float>(val) - 1.0f; }
+  static float stickY(const uint16_t val) { return -stickScale * static_cast<float>(val) + 1.0f; }
+  static float trigger(const uint16_t val) { return triggerScale * static_cast<float>(val); }
+
+  static int16_t clampQ15(const int32_t val) { return static_cast<int16_t>(val < -q15Max ? -q15Max : val); }
+  static int16_t stickXQ15(const uint16_t val) { return clampQ15(static_cast<int32_t>(val) - 0x8000); }
+  static int16_t stickYQ15(const uint16_t val) { return clampQ15(0x7fff - static_cast<int32_t>(val)); }
+  // replicating the top bits into the low bits maps 0x3ff exactly to 0x7fff, larger values would overflow the sign bit
+  static int16_t triggerQ15(const uint16_t val) {
+    const uint16_t clamped = val < triggerMax ? val : triggerMax;
+    return static_cast<int16_t>(clamped << 5 | clamped >> 5);
+  }
 };
@@ -0,0 +1,130 @@
+#include <benchmark/benchmark.h>
+#include <BLEGamepadClient.h>
+#include <esp_timer.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "controllers.h"
+#include "host.h"
+#include "peripherals.h"
+#include "reports.h"
+
+// Time from the allocation of a controller until its first report, with and without cached attributes, with stubbed
+// timing. Every characteristic read and write with response takes a round trip of one connection interval, the first
+// report arrives at the connection event after the controller is connected. Discovery is not simulated, it takes the
+// same round trips in both cases: GATT handles are not cached, NimBLE subscribes only through discovered
+// characteristics.
+//
+// Reported per mode: the mean time from the allocation until the first report and the mean number of round trips. The
+// time column is the simulated time of all the connections.
+
+static constexpr size_t connectionCount = 20;
+
+class MapStorage : public BLEStorage {
+ public:
+  size_t length(const char* key) override { return _values.count(key) ? _values[key].size() : 0; }
+
+  size_t read(const char* key, uint8_t buffer[], const size_t bufferLen) override {
+    const auto len = length(key);
+    if (len == 0 || len > bufferLen) {
+      return 0;
+    }
+    std::copy(_values[key].begin(), _values[key].end(), buffer);
+    return len;
+  }
+
+  bool write(const char* key, const uint8_t data[], const size_t dataLen) override {
+    _values[key].assign(data, data + dataLen);
+    return true;
+  }
+
+  bool remove(const char* key) override {
+    _values.erase(key);
+    return true;
+  }
+
+ private:
+  std::map<std::string, std::vector<uint8_t>> _values;
+};
+
+static int64_t firstReportUs = 0;
+
+static void BM_ConnectToFirstReport(benchmark::State& state, const bool cached, const uint8_t last) {
+  static MapStorage storage;
+  BLEGamepadClient::setStorage(cached ? &storage : nullptr);
+
+  auto& ctrl = controllers::instance<XboxController>();
+  BLEValueReceiver<XboxControlsState>& controls = ctrl;
+  ctrl.begin();
+  controls.onRawReport([](const BLERawReport<XboxControlsState>& report, void*) {
+    if (firstReportUs == 0) {
+      firstReportUs = report.timestampUs;
+    }
+  });
+
+  const auto address = peripherals::address(last);
+  host::addPeripheral(address, peripherals::xbox());
+  const auto pPeripheral = host::findPeripheral(address);
+  // a request and its response are exchanged in consecutive connection events
+  const int64_t connIntervalUs = pPeripheral->connInterval * 1250;
+  pPeripheral->attRoundTripUs = connIntervalUs;
+  const auto advertisement = peripherals::namedAdvertisement("Xbox Wireless Controller");
+  const auto report = reports::Xbox().build();
+
+  host::useManualClock(1000000);
+
+  // fills the cache
+  if (cached && !(controllers::connect(ctrl, address, advertisement) && controllers::disconnect(ctrl))) {
+    state.SkipWithError("controller not connected");
+    host::useRealClock();
+    return;
+  }
+
+  int64_t firstReportUsSum = 0;
+  uint32_t attRequests = 0;
+  for (auto _ : state) {
+    const auto startUs = esp_timer_get_time();
+    for (size_t i = 0; i < connectionCount; i++) {
+      const auto requestsBefore = pPeripheral->attRequests.load();
+      // the time stands still until the controller is allocated, then advances with every round trip
+      const auto allocatedUs = esp_timer_get_time();
+      firstReportUs = 0;
+      if (!controllers::connect(ctrl, address, advertisement)) {
+        state.SkipWithError("controller not connected");
+        break;
+      }
+      host::waitIdle();
+
+      auto* pChar = host::findCharacteristic(host::findClient(address), peripherals::xboxControlsHandle);
+      host::advanceTimeUs(connIntervalUs);
+      host::post([&]() { pChar->notify(report.data(), report.size()); });
+      host::waitIdle();
+
+      firstReportUsSum += firstReportUs - allocatedUs;
+      attRequests += pPeripheral->attRequests.load() - requestsBefore;
+
+      if (!controllers::disconnect(ctrl)) {
+        state.SkipWithError("controller not disconnected");
+        break;
+      }
+      host::advanceTimeUs(1000000);
+    }
+
+    state.SetIterationTime(static_cast<double>(esp_timer_get_time() - startUs) / 1e6);
+  }
+
+  controls.onRawReport(nullptr);
+  BLEGamepadClient::setStorage(nullptr);
+  host::useRealClock();
+
+  state.counters["firstReportMeanMs"] = static_cast<double>(firstReportUsSum) / connectionCount / 1000;
+  state.counters["roundTripsMean"] = static_cast<double>(attRequests) / connectionCount;
+}
+BENCHMARK_CAPTURE(BM_ConnectToFirstReport, Uncached, false, 1)
+    ->UseManualTime()
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ConnectToFirstReport, Cached, true, 2)
+    ->UseManualTime()
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
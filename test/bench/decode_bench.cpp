@@ -0,0 +1,178 @@
+#include <benchmark/benchmark.h>
+#include "reports.h"
+#include "steam/SteamControlsState.h"
+#include "xbox/XboxBatteryState.h"
+#include "xbox/XboxControlsState.h"
+
+// Decode cost per report. Consecutive reports alternate between two values, so that every decode reports a change.
+
+template <typename T>
+static void decodeAlternating(benchmark::State& state, std::vector<uint8_t> a, std::vector<uint8_t> b) {
+  T value;
+  uint32_t changedFields = 0;
+  bool odd = false;
+  for (auto _ : state) {
+    auto& report = odd ? b : a;
+    odd = !odd;
+    benchmark::DoNotOptimize(value.decode(report.data(), report.size(), changedFields));
+    benchmark::DoNotOptimize(changedFields);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_XboxControlsDecode(benchmark::State& state) {
+  reports::Xbox a;
+  reports::Xbox b = a;
+  b.leftStickX = 0x9000;
+  b.buttons[0] = 0x01;
+  decodeAlternating<XboxControlsState>(state, a.build(), b.build());
+}
+BENCHMARK(BM_XboxControlsDecode);
+
+static void BM_XboxBatteryDecode(benchmark::State& state) {
+  decodeAlternating<XboxBatteryState>(state, reports::xboxBattery(50), reports::xboxBattery(51));
+}
+BENCHMARK(BM_XboxBatteryDecode);
+
+// Steam Controller reports carry only the sections announced in their content info, the cost depends on the shape.
+static void BM_SteamControlsDecode(benchmark::State& state, const uint16_t contentInfo) {
+  reports::Steam a;
+  a.contentInfo = contentInfo;
+  reports::Steam b = a;
+  b.buttons[0] = 0x80;
+  b.stickX = 1000;
+  b.leftPadX = -1000;
+  decodeAlternating<SteamControlsState>(state, a.build(), b.build());
+}
+BENCHMARK_CAPTURE(BM_SteamControlsDecode, Buttons, reports::steamButtons);
+BENCHMARK_CAPTURE(BM_SteamControlsDecode, ButtonsTriggersStick,
+                  reports::steamButtons | reports::steamTriggers | reports::steamStick);
+BENCHMARK_CAPTURE(BM_SteamControlsDecode, ButtonsStickPads,
+                  reports::steamButtons | reports::steamStick | reports::steamLeftPad | reports::steamRightPad);
+
+// What a reader polling in a loop does: decode the latest report, then compare the value with the one read before.
+template <typename T>
+static void decodeAndCompare(benchmark::State& state, std::vector<uint8_t> a, std::vector<uint8_t> b) {
+  T value;
+  T previous;
+  uint32_t changedFields = 0;
+  bool odd = false;
+  uint64_t changes = 0;
+  for (auto _ : state) {
+    auto& report = odd ? b : a;
+    odd = !odd;
+    value.decode(report.data(), report.size(), changedFields);
+    if (value != previous) {
+      previous = value;
+      changes++;
+    }
+    benchmark::DoNotOptimize(changes);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_XboxControlsDecodeAndCompare(benchmark::State& state) {
+  reports::Xbox a;
+  reports::Xbox b = a;
+  b.rightTrigger = 0x200;
+  decodeAndCompare<XboxControlsState>(state, a.build(), b.build());
+}
+BENCHMARK(BM_XboxControlsDecodeAndCompare);
+
+static void BM_SteamControlsDecodeAndCompare(benchmark::State& state) {
+  reports::Steam a;
+  a.contentInfo = reports::steamButtons | reports::steamTriggers | reports::steamStick;
+  reports::Steam b = a;
+  b.buttons[0] = 0x80;
+  decodeAndCompare<SteamControlsState>(state, a.build(), b.build());
+}
+BENCHMARK(BM_SteamControlsDecodeAndCompare);
+
+// Decode cost per report including reading every axis, with the float fields and with the Q15 accessors. The float
+// fields are derived by every decode that changes the value, the Q15 accessors only when read. On chips without an
+// FPU the float math is emulated in software, on the host it runs in hardware.
+template <typename T, typename Read>
+static void decodeAndReadAxes(benchmark::State& state, std::vector<uint8_t> a, std::vector<uint8_t> b, Read readAxes) {
+  T value;
+  uint32_t changedFields = 0;
+  bool odd = false;
+  for (auto _ : state) {
+    auto& report = odd ? b : a;
+    odd = !odd;
+    value.decode(report.data(), report.size(), changedFields);
+    readAxes(value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static std::vector<uint8_t> xboxMovedSticks() {
+  reports::Xbox report;
+  report.leftStickX = 0x9000;
+  report.rightStickY = 0x7000;
+  report.leftTrigger = 0x100;
+  return report.build();
+}
+
+static void BM_XboxControlsDecodeFloat(benchmark::State& state) {
+  decodeAndReadAxes<XboxControlsState>(state, reports::Xbox().build(), xboxMovedSticks(),
+                                       [](const XboxControlsState& s) {
+                                         benchmark::DoNotOptimize(s.leftStickX);
+                                         benchmark::DoNotOptimize(s.leftStickY);
+                                         benchmark::DoNotOptimize(s.rightStickX);
+                                         benchmark::DoNotOptimize(s.rightStickY);
+                                         benchmark::DoNotOptimize(s.leftTrigger);
+                                         benchmark::DoNotOptimize(s.rightTrigger);
+                                       });
+}
+BENCHMARK(BM_XboxControlsDecodeFloat);
+
+static void BM_XboxControlsDecodeQ15(benchmark::State& state) {
+  decodeAndReadAxes<XboxControlsState>(state, reports::Xbox().build(), xboxMovedSticks(),
+                                       [](const XboxControlsState& s) {
+                                         benchmark::DoNotOptimize(s.leftStickXQ15());
+                                         benchmark::DoNotOptimize(s.leftStickYQ15());
+                                         benchmark::DoNotOptimize(s.rightStickXQ15());
+                                         benchmark::DoNotOptimize(s.rightStickYQ15());
+                                         benchmark::DoNotOptimize(s.leftTriggerQ15());
+                                         benchmark::DoNotOptimize(s.rightTriggerQ15());
+                                       });
+}
+BENCHMARK(BM_XboxControlsDecodeQ15);
+
+static std::vector<uint8_t> steamMovedStick() {
+  reports::Steam report;
+  report.contentInfo = reports::steamButtons | reports::steamTriggers | reports::steamStick;
+  report.stickX = 1000;
+  report.leftTrigger = 0x80;
+  return report.build();
+}
+
+static void BM_SteamControlsDecodeFloat(benchmark::State& state) {
+  decodeAndReadAxes<SteamControlsState>(state, reports::Steam().build(), steamMovedStick(),
+                                        [](const SteamControlsState& s) {
+                                          benchmark::DoNotOptimize(s.stickX);
+                                          benchmark::DoNotOptimize(s.stickY);
+                                          benchmark::DoNotOptimize(s.leftPadX);
+                                          benchmark::DoNotOptimize(s.leftPadY);
+                                          benchmark::DoNotOptimize(s.rightPadX);
+                                          benchmark::DoNotOptimize(s.rightPadY);
+                                          benchmark::DoNotOptimize(s.leftTrigger);
+                                          benchmark::DoNotOptimize(s.rightTrigger);
+                                        });
+}
+BENCHMARK(BM_SteamControlsDecodeFloat);
+
+static void BM_SteamControlsDecodeQ15(benchmark::State& state) {
+  decodeAndReadAxes<SteamControlsState>(state, reports::Steam().build(), steamMovedStick(),
+                                        [](const SteamControlsState& s) {
+                                          benchmark::DoNotOptimize(s.stickXQ15());
+                                          benchmark::DoNotOptimize(s.stickYQ15());
+                                          benchmark::DoNotOptimize(s.leftPadXQ15());
+                                          benchmark::DoNotOptimize(s.leftPadYQ15());
+                                          benchmark::DoNotOptimize(s.rightPadXQ15());
+                                          benchmark::DoNotOptimize(s.rightPadYQ15());
+                                          benchmark::DoNotOptimize(s.leftTriggerQ15());
+                                          benchmark::DoNotOptimize(s.rightTriggerQ15());
+                                        });
+}
+BENCHMARK(BM_SteamControlsDecodeQ15);
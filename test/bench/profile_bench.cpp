@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+#include <BLEGamepadClient.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "controllers.h"
+#include "host.h"
+#include "peripherals.h"
+#include "reports.h"
+
+// Report inter-arrival times under each connection profile, with stubbed timing. The controls change at random times,
+// and the controller sends the latest controls at the first connection event after a change, at the interval
+// negotiated for the profile. Reports go through the library, which timestamps them with the stubbed clock.
+//
+// Reported per profile: the negotiated interval, the inter-arrival times of the reports and the delay from a change of
+// the controls until the report carrying it arrives. The time column is the simulated time of all the reports.
+
+static constexpr size_t reportCount = 2000;
+static constexpr double meanChangeIntervalUs = 4000;
+
+static std::vector<int64_t> arrivalsUs;
+
+static int64_t percentile(std::vector<int64_t> values, const double p) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  return values[static_cast<size_t>(p * (values.size() - 1))];
+}
+
+static void BM_ReportInterArrival(benchmark::State& state, const BLEConnectionProfile profile, const uint8_t last) {
+  auto& ctrl = controllers::instance<XboxController>();
+  BLEValueReceiver<XboxControlsState>& controls = ctrl;
+  ctrl.begin();
+  ctrl.setConnectionProfile(profile);
+
+  const auto address = peripherals::address(last);
+  host::addPeripheral(address, peripherals::xbox());
+  const auto pPeripheral = host::findPeripheral(address);
+  const auto paramsRequested = [&]() {
+    return profile == BLEConnectionProfile::Default || pPeripheral->connParamsRequests > 0;
+  };
+  if (!controllers::connect(ctrl, address, peripherals::namedAdvertisement("Xbox Wireless Controller")) ||
+      !host::waitFor(paramsRequested)) {
+    state.SkipWithError("controller not connected");
+    return;
+  }
+  host::waitIdle();
+
+  auto* pChar = host::findCharacteristic(host::findClient(address), peripherals::xboxControlsHandle);
+  const int64_t intervalUs = ctrl.getConnectionParams().intervalUs;
+
+  arrivalsUs.clear();
+  arrivalsUs.reserve(reportCount);
+  controls.onRawReport([](const BLERawReport<XboxControlsState>& report, void*) {
+    arrivalsUs.push_back(report.timestampUs);
+  });
+
+  std::vector<int64_t> interArrivalsUs;
+  std::vector<int64_t> delaysUs;
+  for (auto _ : state) {
+    arrivalsUs.clear();
+    delaysUs.clear();
+
+    std::mt19937 rng(1);
+    std::exponential_distribution<double> nextChangeUs(1 / meanChangeIntervalUs);
+    const int64_t startUs = 1000000;
+    host::useManualClock(startUs);
+
+    int64_t changeUs = startUs + static_cast<int64_t>(nextChangeUs(rng));
+    int64_t eventUs = startUs;
+    reports::Xbox report;
+    for (size_t i = 0; i < reportCount; i++) {
+      eventUs += ((changeUs - eventUs) / intervalUs + 1) * intervalUs;
+      delaysUs.push_back(eventUs - changeUs);
+
+      // the changes until the connection event are sent together
+      while (changeUs <= eventUs) {
+        changeUs += static_cast<int64_t>(nextChangeUs(rng));
+      }
+
+      report.leftStickX = static_cast<uint16_t>(i);
+      const auto data = report.build();
+      host::setTimeUs(eventUs);
+      pChar->notify(data.data(), data.size());
+    }
+    host::useRealClock();
+
+    state.SetIterationTime(static_cast<double>(eventUs - startUs) / 1e6);
+  }
+
+  controls.onRawReport(nullptr);
+  controllers::disconnect(ctrl);
+
+  interArrivalsUs.clear();
+  for (size_t i = 1; i < arrivalsUs.size(); i++) {
+    interArrivalsUs.push_back(arrivalsUs[i] - arrivalsUs[i - 1]);
+  }
+  state.counters["intervalUs"] = static_cast<double>(intervalUs);
+  state.counters["interArrivalP50Us"] = static_cast<double>(percentile(interArrivalsUs, 0.5));
+  state.counters["interArrivalP99Us"] = static_cast<double>(percentile(interArrivalsUs, 0.99));
+  state.counters["delayP50Us"] = static_cast<double>(percentile(delaysUs, 0.5));
+  state.counters["delayP99Us"] = static_cast<double>(percentile(delaysUs, 0.99));
+  state.counters["delayMaxUs"] = static_cast<double>(percentile(delaysUs, 1));
+}
+BENCHMARK_CAPTURE(BM_ReportInterArrival, Default, BLEConnectionProfile::Default, 1)
+    ->UseManualTime()
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ReportInterArrival, LowestLatency, BLEConnectionProfile::LowestLatency, 2)
+    ->UseManualTime()
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ReportInterArrival, Balanced, BLEConnectionProfile::Balanced, 3)
+    ->UseManualTime()
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ReportInterArrival, BatterySaver, BLEConnectionProfile::BatterySaver, 4)
+    ->UseManualTime()
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,140 @@
+#include <benchmark/benchmark.h>
+#include <BLEGamepadClient.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "controllers.h"
+#include "host.h"
+#include "peripherals.h"
+#include "reports.h"
+
+// Cost of a notification as seen by the receiving application. The notifications are sent from the benchmark thread,
+// which stands in for the NimBLE host task.
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<Clock::rep> callbackTime{0};
+static std::atomic<uint32_t> callbackCount{0};
+
+static NimBLERemoteCharacteristic* connectXbox(XboxController& ctrl) {
+  static NimBLERemoteCharacteristic* pChar = nullptr;
+  if (pChar == nullptr) {
+    const auto address = peripherals::address(1);
+    host::addPeripheral(address, peripherals::xbox());
+    ctrl.begin();
+    if (controllers::connect(ctrl, address, peripherals::namedAdvertisement("Xbox Wireless Controller"))) {
+      pChar = host::findCharacteristic(host::findClient(address), peripherals::xboxControlsHandle);
+    }
+  }
+  return pChar;
+}
+
+static void recordCallback() {
+  callbackTime.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+  callbackCount.fetch_add(1, std::memory_order_release);
+}
+
+// Time from the notification until the application callback starts, for reports that change the value.
+static void notifyUntilCallback(benchmark::State& state, XboxController& ctrl) {
+  auto* pChar = connectXbox(ctrl);
+  if (pChar == nullptr) {
+    state.SkipWithError("controller not connected");
+    return;
+  }
+
+  reports::Xbox a;
+  reports::Xbox b = a;
+  b.buttons[0] = 0x01;
+  const auto reportA = a.build();
+  const auto reportB = b.build();
+
+  // kept across runs, so that every report differs from the previous one
+  static bool odd = true;
+  for (auto _ : state) {
+    const auto& report = odd ? reportB : reportA;
+    odd = !odd;
+
+    const auto count = callbackCount.load(std::memory_order_acquire);
+    const auto start = Clock::now();
+    pChar->notify(report.data(), report.size());
+    while (callbackCount.load(std::memory_order_acquire) == count) {
+      if (Clock::now() - start > std::chrono::seconds(1)) {
+        state.SkipWithError("callback not invoked");
+        return;
+      }
+      std::this_thread::yield();
+    }
+    const auto end = Clock::time_point(Clock::duration(callbackTime.load(std::memory_order_relaxed)));
+
+    state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+  }
+}
+
+static void BM_RawReportLatency(benchmark::State& state) {
+  auto& ctrl = controllers::instance<XboxController>();
+  BLEValueReceiver<XboxControlsState>& controls = ctrl;
+  controls.onValueChanged(nullptr, nullptr);
+  controls.onRawReport([](const BLERawReport<XboxControlsState>&, void*) { recordCallback(); });
+  notifyUntilCallback(state, ctrl);
+  controls.onRawReport(nullptr);
+}
+BENCHMARK(BM_RawReportLatency)->UseManualTime();
+
+static void BM_ValueChangedLatency(benchmark::State& state) {
+  auto& ctrl = controllers::instance<XboxController>();
+  BLEValueReceiver<XboxControlsState>& controls = ctrl;
+  controls.onRawReport(nullptr);
+  controls.onValueChanged([](XboxControlsState&, uint32_t, void*) { recordCallback(); }, nullptr);
+  notifyUntilCallback(state, ctrl);
+  controls.onValueChanged(nullptr, nullptr);
+}
+BENCHMARK(BM_ValueChangedLatency)->UseManualTime();
+
+static void BM_ValueChangedLatencyFunction(benchmark::State& state) {
+  auto& ctrl = controllers::instance<XboxController>();
+  BLEValueReceiver<XboxControlsState>& controls = ctrl;
+  controls.onRawReport(nullptr);
+  controls.onValueChanged(OnFieldsChanged<XboxControlsState>([](XboxControlsState&, uint32_t) { recordCallback(); }));
+  notifyUntilCallback(state, ctrl);
+  controls.onValueChanged(nullptr, nullptr);
+}
+BENCHMARK(BM_ValueChangedLatencyFunction)->UseManualTime();
+
+static void BM_ValueChangedLatencyValueOnly(benchmark::State& state) {
+  auto& ctrl = controllers::instance<XboxController>();
+  BLEValueReceiver<XboxControlsState>& controls = ctrl;
+  controls.onRawReport(nullptr);
+  controls.onValueChanged(OnValueChanged<XboxControlsState>([](XboxControlsState&) { recordCallback(); }));
+  notifyUntilCallback(state, ctrl);
+  controls.onValueChanged(nullptr, nullptr);
+}
+BENCHMARK(BM_ValueChangedLatencyValueOnly)->UseManualTime();
+
+// Cost of invoking the stored callback, paid once per notification that changes the value.
+static void countCallback(XboxControlsState&, uint32_t changedFields, void* pArg) {
+  *static_cast<uint32_t*>(pArg) += changedFields;
+}
+
+static void BM_CallbackInvokeFnPointer(benchmark::State& state) {
+  uint32_t sum = 0;
+  BLECallback<XboxControlsState&, uint32_t> callback;
+  callback.set(countCallback, &sum);
+  XboxControlsState value;
+  for (auto _ : state) {
+    callback(value, 1);
+  }
+  benchmark::DoNotOptimize(sum);
+}
+BENCHMARK(BM_CallbackInvokeFnPointer);
+
+static void BM_CallbackInvokeFunction(benchmark::State& state) {
+  uint32_t sum = 0;
+  BLECallback<XboxControlsState&, uint32_t> callback;
+  callback.set([&sum](XboxControlsState&, uint32_t changedFields) { sum += changedFields; });
+  XboxControlsState value;
+  for (auto _ : state) {
+    callback(value, 1);
+  }
+  benchmark::DoNotOptimize(sum);
+}
+BENCHMARK(BM_CallbackInvokeFunction);
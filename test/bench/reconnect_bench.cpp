@@ -0,0 +1,152 @@
+#include <benchmark/benchmark.h>
+#include <BLEGamepadClient.h>
+#include <random>
+#include "controllers.h"
+#include "host.h"
+#include "peripherals.h"
+
+// Reconnect time and scan airtime of a known controller, with open scans and with accept list scans, with stubbed
+// timing. After each disconnect the controller is off for a while, then advertises every advertising interval plus
+// the random advertising delay of the BLE specification. An advertisement is received if it falls into a scan window
+// of the scan running at that time, scans end when their duration elapses.
+//
+// Reported per mode: the time from the disconnect until the connection is initiated and the scan airtime spent on it,
+// which is the scan time weighted by the scan window and interval. The time column is the simulated time of all the
+// reconnects. With AddressChanged, the controller advertises from another address after every disconnect, so accept
+// list scans don't find it until they fall back to open scans, see CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_TIMEOUT_MS.
+
+static constexpr size_t reconnectCount = 20;
+static constexpr int64_t advIntervalUs = 50000;
+static constexpr int64_t maxAdvDelayUs = 10000;
+static constexpr int64_t reconnectLimitUs = 120000000;
+
+static uint64_t airtimeUs(const BLEScanStats& stats) {
+  return stats.open.airtimeUs + stats.acceptList.airtimeUs;
+}
+
+// delivers the advertisements of the controller from the given time until one of them initiates a connection,
+// returns the time of that advertisement or 0 if none did within the limit
+static int64_t advertiseUntilAllocated(XboxController& ctrl, const NimBLEAdvertisedDevice& adv, int64_t advUs,
+                                       std::mt19937& rng) {
+  auto* pScan = NimBLEDevice::getScan();
+  std::uniform_int_distribution<int64_t> advDelayUs(0, maxAdvDelayUs);
+  const auto limitUs = advUs + reconnectLimitUs;
+
+  while (ctrl.getAddress().isNull()) {
+    advUs += advIntervalUs + advDelayUs(rng);
+    if (advUs > limitUs) {
+      return 0;
+    }
+
+    // a scan that reaches its duration ends, auto-scan may start the next one
+    const auto scanEndUs = pScan->getStartUs() + static_cast<int64_t>(pScan->getDuration()) * 1000;
+    if (pScan->isScanning() && advUs >= scanEndUs) {
+      host::setTimeUs(scanEndUs);
+      const auto starts = pScan->getStartCount();
+      pScan->end(0);
+      host::waitFor([&]() { return pScan->getStartCount() != starts; }, 100);
+    }
+
+    host::setTimeUs(advUs);
+    const int64_t intervalUs = pScan->getInterval() * 1000;
+    const int64_t windowUs = pScan->getWindow() * 1000;
+    if (pScan->isScanning() && (advUs - pScan->getStartUs()) % intervalUs < windowUs) {
+      pScan->deliver(&adv);
+    }
+  }
+
+  return advUs;
+}
+
+static void BM_Reconnect(benchmark::State& state, const bool acceptList, const int64_t offUs,
+                         const bool addressChanges, const uint8_t last) {
+  auto& ctrl = controllers::instance<XboxController>();
+  auto* pAutoScan = BLEGamepadClient::getAutoScan();
+  auto* pScan = NimBLEDevice::getScan();
+  ctrl.begin();
+
+  const NimBLEAddress addresses[] = {peripherals::address(last), peripherals::address(last + 100)};
+  for (const auto& address : addresses) {
+    host::addPeripheral(address, peripherals::xbox());
+  }
+  const auto advertisement = peripherals::namedAdvertisement("Xbox Wireless Controller");
+  const NimBLEAdvertisedDevice advs[] = {{addresses[0], advertisement}, {addresses[1], advertisement}};
+
+  int64_t nowUs = 1000000;
+  host::useManualClock(nowUs);
+  if (!controllers::connect(ctrl, addresses[0], advertisement)) {
+    state.SkipWithError("controller not connected");
+    host::useRealClock();
+    return;
+  }
+  host::waitIdle();
+
+  // applies to the scans started after the disconnects below
+  pAutoScan->setAcceptListScan(acceptList);
+
+  std::mt19937 rng(last);
+  size_t advIndex = 0;
+  int64_t reconnectUsSum = 0;
+  int64_t reconnectUsMax = 0;
+  uint64_t airtimeUsSum = 0;
+  for (auto _ : state) {
+    const auto startUs = nowUs;
+    for (size_t i = 0; i < reconnectCount; i++) {
+      const auto airtimeBeforeUs = airtimeUs(pAutoScan->getScanStats());
+      const auto disconnectUs = nowUs;
+      const auto starts = pScan->getStartCount();
+      if (!controllers::disconnect(ctrl) || !host::waitFor([&]() { return pScan->getStartCount() != starts; })) {
+        state.SkipWithError("auto-scan not started");
+        break;
+      }
+
+      if (addressChanges) {
+        advIndex = 1 - advIndex;
+      }
+      const auto connectUs = advertiseUntilAllocated(ctrl, advs[advIndex], disconnectUs + offUs, rng);
+      if (connectUs == 0 || !host::waitFor([&]() { return ctrl.isConnected(); })) {
+        state.SkipWithError("controller not reconnected");
+        break;
+      }
+      host::waitIdle();
+
+      reconnectUsSum += connectUs - disconnectUs;
+      reconnectUsMax = std::max(reconnectUsMax, connectUs - disconnectUs);
+      airtimeUsSum += airtimeUs(pAutoScan->getScanStats()) - airtimeBeforeUs;
+
+      // stays connected for a while
+      nowUs = connectUs + 1000000;
+      host::setTimeUs(nowUs);
+    }
+
+    state.SetIterationTime(static_cast<double>(nowUs - startUs) / 1e6);
+  }
+
+  pAutoScan->setAcceptListScan(CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_ENABLED > 0);
+  controllers::disconnect(ctrl);
+  host::useRealClock();
+
+  state.counters["reconnectMeanMs"] = static_cast<double>(reconnectUsSum) / reconnectCount / 1000;
+  state.counters["reconnectMaxMs"] = static_cast<double>(reconnectUsMax) / 1000;
+  state.counters["airtimeMeanMs"] = static_cast<double>(airtimeUsSum) / reconnectCount / 1000;
+}
+BENCHMARK_CAPTURE(BM_Reconnect, OpenImmediate, false, 0, false, 1)
+    ->UseManualTime()
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Reconnect, AcceptListImmediate, true, 0, false, 2)
+    ->UseManualTime()
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Reconnect, OpenAfter5s, false, 5000000, false, 3)
+    ->UseManualTime()
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Reconnect, AcceptListAfter5s, true, 5000000, false, 4)
+    ->UseManualTime()
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Reconnect, AcceptListAddressChanged, true, 0, true, 5)
+    ->UseManualTime()
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,50 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+// Runs a libFuzzer harness without libFuzzer, for compilers that do not ship it. Replays the files given on the
+// command line, or without arguments a fixed number of random reports, most of them shaped like controller reports.
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static constexpr size_t randomRuns = 200000;
+static constexpr size_t maxLen = 64;
+static constexpr size_t reportLens[] = {1, 16, 19, 20};
+
+int main(const int argc, char** argv) {
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      std::ifstream file(argv[i], std::ios::binary);
+      if (!file) {
+        fprintf(stderr, "Cannot open %s\n", argv[i]);
+        return 1;
+      }
+      const std::vector<uint8_t> input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+      LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    return 0;
+  }
+
+  std::mt19937 rng(0x626c6567);
+  std::uniform_int_distribution<int> byte(0, 0xff);
+  std::uniform_int_distribution<size_t> len(0, maxLen);
+  std::uniform_int_distribution<size_t> reportLen(0, std::size(reportLens) - 1);
+  for (size_t run = 0; run < randomRuns; run++) {
+    // controllers send reports of a few fixed lengths with fixed leading bytes, keep these most of the time so that
+    // the decoders get past their checks
+    std::vector<uint8_t> input(run % 4 == 0 ? len(rng) : reportLens[reportLen(rng)]);
+    for (auto& b : input) {
+      b = byte(rng);
+    }
+    if (run % 2 == 1 && input.size() >= 2) {
+      input[0] = 0xc0;
+      input[1] = (input[1] & 0xf0) | 0x04;
+    }
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+  }
+  printf("Ran %zu random inputs\n", randomRuns);
+  return 0;
+}
@@ -0,0 +1,26 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "steam/SteamControlsState.h"
+
+// Feeds arbitrary reports to the Steam Controller decoder, built with the address sanitizer so that a read past the
+// end of the report fails the run.
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, const size_t size) {
+  // decode() takes a mutable buffer, copy the input so that the sanitizer sees its exact length
+  std::vector<uint8_t> report(data, data + size);
+
+  SteamControlsState state;
+  uint32_t changedFields = 0;
+  const auto result = state.decode(report.data(), report.size(), changedFields);
+  if (result != BLEDecodeResult::Success && changedFields != 0) {
+    __builtin_trap();
+  }
+
+  // decoding the same report again never reports a change
+  if (result == BLEDecodeResult::Success && state.decode(report.data(), report.size(), changedFields) ==
+                                               BLEDecodeResult::Success && changedFields != 0) {
+    __builtin_trap();
+  }
+  return 0;
+}
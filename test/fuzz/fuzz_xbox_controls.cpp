@@ -0,0 +1,20 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "xbox/XboxBatteryState.h"
+#include "xbox/XboxControlsState.h"
+
+// Feeds arbitrary reports to the Xbox controls and battery decoders, built with the address sanitizer so that a read
+// past the end of the report fails the run.
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, const size_t size) {
+  // decode() takes a mutable buffer, copy the input so that the sanitizer sees its exact length
+  std::vector<uint8_t> report(data, data + size);
+
+  uint32_t changedFields = 0;
+  XboxControlsState controls;
+  controls.decode(report.data(), report.size(), changedFields);
+  XboxBatteryState battery;
+  battery.decode(report.data(), report.size(), changedFields);
+  return 0;
+}
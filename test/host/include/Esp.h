@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Arduino.h"
+
+class EspClass {
+ public:
+  const char* getChipModel();
+};
+
+extern EspClass ESP;
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#define BLE_DEV_ADDR_LEN 6
+
+#define BLE_ADDR_PUBLIC 0x00
+#define BLE_ADDR_RANDOM 0x01
+
+struct ble_addr_t {
+  uint8_t type;
+  uint8_t val[BLE_DEV_ADDR_LEN];
+};
+
+/// @brief Host stand-in for a Bluetooth device address, laid out like the one of NimBLE-Arduino 2.x.
+class NimBLEAddress : private ble_addr_t {
+ public:
+  NimBLEAddress();
+  NimBLEAddress(uint64_t address, uint8_t type);
+  NimBLEAddress(const std::string& address, uint8_t type);
+
+  bool isNull() const;
+  uint8_t getType() const { return type; }
+  const uint8_t* getVal() const { return val; }
+  std::string toString() const { return std::string(*this); }
+
+  bool operator==(const NimBLEAddress& rhs) const;
+  bool operator!=(const NimBLEAddress& rhs) const { return !(*this == rhs); }
+  explicit operator uint64_t() const;
+  operator std::string() const;
+};
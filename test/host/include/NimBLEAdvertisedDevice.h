@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "NimBLEAddress.h"
+
+#define BLE_HS_ADV_TYPE_FLAGS 0x01
+#define BLE_HS_ADV_TYPE_INCOMP_UUIDS16 0x02
+#define BLE_HS_ADV_TYPE_COMP_UUIDS16 0x03
+#define BLE_HS_ADV_TYPE_INCOMP_NAME 0x08
+#define BLE_HS_ADV_TYPE_COMP_NAME 0x09
+#define BLE_HS_ADV_TYPE_APPEARANCE 0x19
+#define BLE_HS_ADV_TYPE_MFG_DATA 0xff
+
+/// @brief Host stand-in for an advertising device, built from the raw advertisement payload.
+class NimBLEAdvertisedDevice {
+ public:
+  NimBLEAdvertisedDevice(const NimBLEAddress& address, std::vector<uint8_t> payload);
+
+  NimBLEAddress getAddress() const { return _address; }
+  uint8_t getAddressType() const { return _address.getType(); }
+  const std::vector<uint8_t>& getPayload() const { return _payload; }
+  bool haveType(uint16_t type) const;
+  std::string getPayloadByType(uint16_t type, uint8_t index = 0) const;
+  bool haveName() const { return haveType(BLE_HS_ADV_TYPE_COMP_NAME); }
+  std::string getName() const { return getPayloadByType(BLE_HS_ADV_TYPE_COMP_NAME); }
+
+ private:
+  size_t _findType(uint16_t type, uint8_t index, size_t* pDataLen) const;
+
+  NimBLEAddress _address;
+  std::vector<uint8_t> _payload;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// @brief Host stand-in for the value of an attribute.
+class NimBLEAttValue {
+ public:
+  NimBLEAttValue() = default;
+  NimBLEAttValue(const uint8_t* data, size_t len) : _data(data, data + len) { _data.push_back(0); }
+  explicit NimBLEAttValue(const std::vector<uint8_t>& data) : NimBLEAttValue(data.data(), data.size()) {}
+
+  const uint8_t* data() const { return _data.data(); }
+  const char* c_str() const { return reinterpret_cast<const char*>(_data.data()); }
+  size_t size() const { return _data.empty() ? 0 : _data.size() - 1; }
+  size_t length() const { return size(); }
+  const uint8_t* begin() const { return data(); }
+  const uint8_t* end() const { return data() + size(); }
+
+ private:
+  // kept null terminated, like the original
+  std::vector<uint8_t> _data{0};
+};
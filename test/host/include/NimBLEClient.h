@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "NimBLEAddress.h"
+#include "NimBLEConnInfo.h"
+#include "NimBLERemoteCharacteristic.h"
+#include "NimBLEUUID.h"
+
+class NimBLEClient;
+
+namespace host {
+struct Peripheral;
+}
+
+class NimBLEClientCallbacks {
+ public:
+  virtual ~NimBLEClientCallbacks() = default;
+  virtual void onConnect(NimBLEClient* pClient) {}
+  virtual void onConnectFail(NimBLEClient* pClient, int reason) {}
+  virtual void onDisconnect(NimBLEClient* pClient, int reason) {}
+  virtual void onAuthenticationComplete(NimBLEConnInfo& connInfo) {}
+  virtual void onConnParamsUpdate(NimBLEClient* pClient) {}
+};
+
+/**
+ * @brief Host stand-in for a GATT client. Connecting, securing and disconnecting complete asynchronously on the host
+ * task, against the peripheral registered with `host::addPeripheral()` for the peer address.
+ */
+class NimBLEClient {
+ public:
+  explicit NimBLEClient(const NimBLEAddress& peerAddress);
+  ~NimBLEClient();
+
+  bool connect(bool deleteAttributes = true, bool asyncConnect = false, bool exchangeMTU = true);
+  bool disconnect(uint8_t reason = 0x13);
+  bool cancelConnect() const;
+  bool isConnected() const;
+  bool secureConnection(bool async = false) const;
+  NimBLEAddress getPeerAddress() const { return _peerAddress; }
+  void setSelfDelete(bool deleteOnDisconnect, bool deleteOnConnectFail) {}
+  void setConnectTimeout(uint32_t timeoutMs) { _connectTimeoutMs = timeoutMs; }
+  void setClientCallbacks(NimBLEClientCallbacks* pClientCallbacks, bool deleteCallbacks = true);
+  NimBLERemoteService* getService(const NimBLEUUID& uuid);
+  const std::vector<NimBLERemoteService*>& getServices(bool refresh = false);
+  bool updateConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout);
+  NimBLEConnInfo getConnInfo() const;
+
+  // host only
+  std::shared_ptr<host::Peripheral> getPeripheral() const { return _pPeripheral; }
+  uint32_t getConnectTimeout() const { return _connectTimeoutMs; }
+
+ private:
+  void _onConnected();
+  void _onDisconnected(int reason);
+
+  NimBLEAddress _peerAddress;
+  std::shared_ptr<host::Peripheral> _pPeripheral;
+  NimBLEClientCallbacks* _pCallbacks;
+  uint32_t _connectTimeoutMs;
+  std::atomic_bool _connecting;
+  std::atomic_bool _connected;
+  mutable std::mutex _connInfoMutex;
+  NimBLEConnInfo _connInfo;
+  std::vector<std::unique_ptr<NimBLERemoteService>> _owned;
+  std::vector<NimBLERemoteService*> _services;
+};
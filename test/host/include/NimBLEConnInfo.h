@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include "NimBLEAddress.h"
+
+/// @brief Host stand-in for the information of a connection.
+class NimBLEConnInfo {
+ public:
+  NimBLEAddress getAddress() const { return address; }
+  NimBLEAddress getIdAddress() const { return address; }
+  uint16_t getConnHandle() const { return connHandle; }
+  uint16_t getConnInterval() const { return connInterval; }
+  uint16_t getConnLatency() const { return connLatency; }
+  uint16_t getConnTimeout() const { return connTimeout; }
+  bool isBonded() const { return bonded; }
+  bool isEncrypted() const { return encrypted; }
+
+  NimBLEAddress address{};
+  uint16_t connHandle{0};
+  uint16_t connInterval{0};
+  uint16_t connLatency{0};
+  uint16_t connTimeout{0};
+  bool bonded{false};
+  bool encrypted{false};
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+// Host stand-in for NimBLE-Arduino 2.x. Only the API used by the library is provided.
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <freertos/timers.h>
+#include <cstdint>
+#include <string>
+#include "NimBLEAddress.h"
+#include "NimBLEAdvertisedDevice.h"
+#include "NimBLEAttValue.h"
+#include "NimBLEClient.h"
+#include "NimBLEConnInfo.h"
+#include "NimBLERemoteCharacteristic.h"
+#include "NimBLEScan.h"
+#include "NimBLEUUID.h"
+#include "NimBLEUtils.h"
+#include "nimconfig.h"
+
+#define BLE_HS_IO_DISPLAY_ONLY 0x00
+#define BLE_HS_IO_DISPLAY_YESNO 0x01
+#define BLE_HS_IO_KEYBOARD_ONLY 0x02
+#define BLE_HS_IO_NO_INPUT_OUTPUT 0x03
+#define BLE_HS_IO_KEYBOARD_DISPLAY 0x04
+
+#define BLE_SM_PAIR_AUTHREQ_BOND 0x01
+#define BLE_SM_PAIR_AUTHREQ_MITM 0x04
+#define BLE_SM_PAIR_AUTHREQ_SC 0x08
+
+#define BLE_HS_ETIMEOUT 13
+#define BLE_HS_ENOTCONN 7
+
+class NimBLEDevice {
+ public:
+  static bool init(const std::string& deviceName);
+  static bool deinit(bool clearAll = false);
+  static bool isInitialized();
+  static bool setPower(int8_t dbm) { return true; }
+  static void setSecurityAuth(uint8_t authReq) {}
+  static void setSecurityIOCap(uint8_t ioCap) {}
+  static bool deleteAllBonds();
+  static int getNumBonds();
+  static NimBLEAddress getBondedAddress(int index);
+  static NimBLEScan* getScan();
+  static NimBLEClient* createClient(const NimBLEAddress& peerAddress);
+  static bool deleteClient(NimBLEClient* pClient);
+  static bool whiteListAdd(const NimBLEAddress& address);
+  static bool whiteListRemove(const NimBLEAddress& address);
+  static bool onWhiteList(const NimBLEAddress& address);
+  static size_t getWhiteListCount();
+  static NimBLEAddress getWhiteListAddress(size_t index);
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "NimBLEAttValue.h"
+#include "NimBLEUUID.h"
+
+#define BLE_GATT_CHR_PROP_BROADCAST 0x01
+#define BLE_GATT_CHR_PROP_READ 0x02
+#define BLE_GATT_CHR_PROP_WRITE_NO_RSP 0x04
+#define BLE_GATT_CHR_PROP_WRITE 0x08
+#define BLE_GATT_CHR_PROP_NOTIFY 0x10
+#define BLE_GATT_CHR_PROP_INDICATE 0x20
+#define BLE_GATT_CHR_PROP_AUTH_SIGN_WRITE 0x40
+#define BLE_GATT_CHR_PROP_EXTENDED 0x80
+
+class NimBLEClient;
+class NimBLERemoteService;
+
+/// @brief Host stand-in for a descriptor of a remote characteristic, holding a fixed value.
+class NimBLERemoteDescriptor {
+ public:
+  NimBLERemoteDescriptor(const NimBLEUUID& uuid, std::vector<uint8_t> value);
+
+  NimBLEUUID getUUID() const { return _uuid; }
+  NimBLEAttValue readValue();
+
+ private:
+  NimBLEUUID _uuid;
+  std::vector<uint8_t> _value;
+};
+
+/**
+ * @brief Host stand-in for a characteristic of a connected device. Notifications are delivered by calling
+ * `notify()`, which runs the handler on the calling thread, post it with `host::post()` to run it on the host task.
+ * Values written by the library are kept in `getWrites()`.
+ */
+class NimBLERemoteCharacteristic {
+ public:
+  using notify_callback = std::function<void(NimBLERemoteCharacteristic* pChar, uint8_t* pData, size_t length,
+                                             bool isNotify)>;
+
+  NimBLERemoteCharacteristic(const NimBLEUUID& uuid,
+                             uint16_t handle,
+                             uint8_t properties,
+                             NimBLEClient* pClient = nullptr,
+                             const NimBLERemoteService* pService = nullptr);
+
+  bool canBroadcast() const { return _properties & BLE_GATT_CHR_PROP_BROADCAST; }
+  bool canRead() const { return _properties & BLE_GATT_CHR_PROP_READ; }
+  bool canWriteNoResponse() const { return _properties & BLE_GATT_CHR_PROP_WRITE_NO_RSP; }
+  bool canWrite() const { return _properties & BLE_GATT_CHR_PROP_WRITE; }
+  bool canNotify() const { return _properties & BLE_GATT_CHR_PROP_NOTIFY; }
+  bool canIndicate() const { return _properties & BLE_GATT_CHR_PROP_INDICATE; }
+  bool canWriteSigned() const { return _properties & BLE_GATT_CHR_PROP_AUTH_SIGN_WRITE; }
+  bool hasExtendedProps() const { return _properties & BLE_GATT_CHR_PROP_EXTENDED; }
+
+  NimBLEUUID getUUID() const { return _uuid; }
+  uint16_t getHandle() const { return _handle; }
+  NimBLEClient* getClient() const { return _pClient; }
+  const NimBLERemoteService* getRemoteService() const { return _pService; }
+  NimBLERemoteDescriptor* getDescriptor(const NimBLEUUID& uuid) const;
+
+  bool subscribe(bool notifications = true, const notify_callback& notifyCallback = nullptr, bool response = true);
+  bool unsubscribe(bool response = true);
+  NimBLEAttValue readValue();
+  bool writeValue(const uint8_t* data, size_t length, bool response = false) const;
+
+  // host only
+  void setValue(std::vector<uint8_t> value);
+  void addDescriptor(const NimBLEUUID& uuid, std::vector<uint8_t> value);
+  bool isSubscribed() const;
+  void notify(const uint8_t* data, size_t length);
+  std::vector<std::vector<uint8_t>> getWrites() const;
+  uint32_t getReadCount() const { return _readCount; }
+
+ private:
+  NimBLEUUID _uuid;
+  uint16_t _handle;
+  uint8_t _properties;
+  NimBLEClient* _pClient;
+  const NimBLERemoteService* _pService;
+  std::vector<uint8_t> _value;
+  std::vector<std::unique_ptr<NimBLERemoteDescriptor>> _descriptors;
+  notify_callback _notifyCallback;
+  bool _subscribed;
+  uint32_t _readCount;
+  mutable std::mutex _writesMutex;
+  mutable std::vector<std::vector<uint8_t>> _writes;
+};
+
+/// @brief Host stand-in for a service of a connected device.
+class NimBLERemoteService {
+ public:
+  NimBLERemoteService(const NimBLEUUID& uuid, uint16_t handle);
+
+  NimBLEUUID getUUID() const { return _uuid; }
+  uint16_t getHandle() const { return _handle; }
+  NimBLERemoteCharacteristic* getCharacteristic(const NimBLEUUID& uuid) const;
+  const std::vector<NimBLERemoteCharacteristic*>& getCharacteristics(bool refresh = false) const;
+
+  // host only
+  NimBLERemoteCharacteristic* addCharacteristic(std::unique_ptr<NimBLERemoteCharacteristic> pChar);
+
+ private:
+  NimBLEUUID _uuid;
+  uint16_t _handle;
+  std::vector<std::unique_ptr<NimBLERemoteCharacteristic>> _owned;
+  std::vector<NimBLERemoteCharacteristic*> _characteristics;
+};
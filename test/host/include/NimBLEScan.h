@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "NimBLEAdvertisedDevice.h"
+
+#define BLE_HCI_SCAN_FILT_NO_WL 0
+#define BLE_HCI_SCAN_FILT_USE_WL 1
+
+class NimBLEScanResults {};
+
+class NimBLEScanCallbacks {
+ public:
+  virtual ~NimBLEScanCallbacks() = default;
+  virtual void onDiscovered(const NimBLEAdvertisedDevice* pAdvertisedDevice) {}
+  virtual void onResult(const NimBLEAdvertisedDevice* pAdvertisedDevice) {}
+  virtual void onScanEnd(const NimBLEScanResults& scanResults, int reason) {}
+};
+
+/**
+ * @brief Host stand-in for the scanner. Advertisements are delivered with `deliver()`, which applies the filter
+ * policy like the controller would. `deliver()` and `end()` run the callbacks on the host task and wait for them, so
+ * they must not be called from the host task.
+ */
+class NimBLEScan {
+ public:
+  void setScanCallbacks(NimBLEScanCallbacks* pScanCallbacks, bool wantDuplicates = false);
+  void setMaxResults(uint8_t maxResults) {}
+  void setActiveScan(bool active) { _active = active; }
+  void setInterval(uint16_t intervalMs) { _intervalMs = intervalMs; }
+  void setWindow(uint16_t windowMs) { _windowMs = windowMs; }
+  void setFilterPolicy(uint8_t filterPolicy) { _filterPolicy = filterPolicy; }
+  bool start(uint32_t durationMs, bool isContinue = false, bool restart = true);
+  bool stop();
+  bool isScanning() const { return _scanning; }
+
+  // host only
+  /// @return True if the advertisement passed the filter policy of a running scan.
+  bool deliver(const NimBLEAdvertisedDevice* pAdvertisedDevice);
+  void end(int reason);
+  NimBLEScanCallbacks* getScanCallbacks() const { return _pCallbacks; }
+  uint16_t getInterval() const { return _intervalMs; }
+  uint16_t getWindow() const { return _windowMs; }
+  uint8_t getFilterPolicy() const { return _filterPolicy; }
+  bool isActive() const { return _active; }
+  uint32_t getDuration() const { return _durationMs; }
+  int64_t getStartUs() const { return _startUs; }
+  uint32_t getStartCount() const { return _startCount; }
+
+ private:
+  NimBLEScanCallbacks* _pCallbacks{nullptr};
+  std::atomic_bool _scanning{false};
+  bool _active{false};
+  uint16_t _intervalMs{0};
+  uint16_t _windowMs{0};
+  uint8_t _filterPolicy{BLE_HCI_SCAN_FILT_NO_WL};
+  uint32_t _durationMs{0};
+  int64_t _startUs{0};
+  std::atomic<uint32_t> _startCount{0};
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/// @brief Host stand-in for a 16-bit or 128-bit attribute UUID.
+class NimBLEUUID {
+ public:
+  NimBLEUUID() = default;
+  NimBLEUUID(uint16_t uuid16);
+  NimBLEUUID(const std::string& uuid);
+  NimBLEUUID(const char* uuid);
+
+  uint8_t bitSize() const { return _bitSize; }
+  bool operator==(const NimBLEUUID& rhs) const;
+  bool operator!=(const NimBLEUUID& rhs) const { return !(*this == rhs); }
+  operator std::string() const;
+  std::string toString() const { return std::string(*this); }
+
+ private:
+  uint8_t _bitSize{0};
+  uint16_t _uuid16{0};
+  std::string _uuid128;
+};
@@ -0,0 +1,6 @@
+#pragma once
+
+class NimBLEUtils {
+ public:
+  static const char* returnCodeToString(int rc);
+};
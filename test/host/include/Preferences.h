@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// @brief Host stand-in for the Arduino Preferences library, keeping the namespaces in memory.
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+  void end();
+  bool isKey(const char* key);
+  bool remove(const char* key);
+  bool clear();
+  size_t putBytes(const char* key, const void* value, size_t len);
+  size_t getBytesLength(const char* key);
+  size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+ private:
+  std::string _name;
+  bool _started{false};
+  bool _readOnly{true};
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+typedef enum {
+  ESP_LOG_NONE,
+  ESP_LOG_ERROR,
+  ESP_LOG_WARN,
+  ESP_LOG_INFO,
+  ESP_LOG_DEBUG,
+  ESP_LOG_VERBOSE,
+  ESP_LOG_MAX,
+} esp_log_level_t;
+
+void esp_log_level_set(const char* tag, esp_log_level_t level);
+esp_log_level_t esp_log_level_get(const char* tag);
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+// like on the device, the arguments are evaluated regardless of the level of the tag
+#define ESP_LOG_LEVEL(level, tag, format, ...) esp_log_write(level, tag, format "\n", ##__VA_ARGS__)
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Microseconds since start, or the manual time set with `host::setTimeUs()`.
+int64_t esp_timer_get_time();
@@ -0,0 +1,35 @@
+#pragma once
+
+// Host stand-in for the FreeRTOS kernel, backed by std::thread. Only the API used by the library is provided.
+
+#include <cstddef>
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+typedef struct HostTask* TaskHandle_t;
+typedef struct HostQueue* QueueHandle_t;
+typedef struct HostSemaphore* SemaphoreHandle_t;
+typedef struct HostTimer* TimerHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY 0xffffffffu
+#define pdMS_TO_TICKS(xTimeInMs) \
+  ((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+void hostAssertFailed(const char* expr, const char* file, int line);
+
+#define configASSERT(x)                             \
+  do {                                              \
+    if (!(x)) {                                     \
+      hostAssertFailed(#x, __FILE__, __LINE__);     \
+    }                                               \
+  } while (0)
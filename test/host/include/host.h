@@ -0,0 +1,91 @@
+#pragma once
+
+// Control over the host stand-ins, for tests and benchmarks.
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "NimBLEDevice.h"
+
+namespace host {
+
+/// @brief Makes `esp_timer_get_time()` and `millis()` return a time set by the caller, starting at `startUs`.
+void useManualClock(int64_t startUs = 1);
+
+/// @brief Makes `esp_timer_get_time()` and `millis()` follow the steady clock again.
+void useRealClock();
+
+void setTimeUs(int64_t timeUs);
+void advanceTimeUs(int64_t deltaUs);
+
+/// @brief Runs the callbacks of the software timers that are due, on the calling thread. Due timers are also run by
+/// the timer service task every millisecond.
+void fireTimers();
+
+/// @brief Runs the function on the BLE host task, after the previously posted ones.
+void post(std::function<void()> fn);
+
+/// @brief Waits until the BLE host task has run all posted functions.
+void waitIdle();
+
+/// @brief Polls the condition until it holds or the timeout expires.
+/// @return True if the condition holds.
+bool waitFor(const std::function<bool()>& condition, uint32_t timeoutMs = 5000);
+
+struct CharacteristicSpec {
+  NimBLEUUID uuid;
+  uint16_t handle;
+  uint8_t properties;
+  std::vector<uint8_t> value{};
+  std::vector<std::pair<NimBLEUUID, std::vector<uint8_t>>> descriptors{};
+};
+
+struct ServiceSpec {
+  NimBLEUUID uuid;
+  std::vector<CharacteristicSpec> characteristics;
+};
+
+/// @brief Device a client connects to, identified by its address.
+struct Peripheral {
+  NimBLEAddress address;
+  std::vector<ServiceSpec> services;
+
+  bool acceptsConnection{true};
+  bool bonds{true};
+
+  /// @brief Whether connection parameter update requests are accepted. The largest interval of the requested range
+  /// is picked.
+  bool acceptsConnParams{true};
+
+  /// @brief Interval, latency and timeout in effect after connecting, in the units of the BLE specification.
+  uint16_t connInterval{24};
+  uint16_t connLatency{0};
+  uint16_t connTimeout{400};
+
+  std::atomic<uint32_t> connects{0};
+  std::atomic<uint32_t> connParamsRequests{0};
+
+  /// @brief Time, in microseconds, by which each characteristic read and write with response advances the manual clock.
+  int64_t attRoundTripUs{0};
+
+  /// @brief Number of characteristic reads and writes with response, each takes a round trip over the air.
+  std::atomic<uint32_t> attRequests{0};
+};
+
+std::shared_ptr<Peripheral> addPeripheral(const NimBLEAddress& address, std::vector<ServiceSpec> services);
+std::shared_ptr<Peripheral> findPeripheral(const NimBLEAddress& address);
+
+/// @brief Returns the client currently connecting or connected to the address, if any.
+NimBLEClient* findClient(const NimBLEAddress& address);
+
+/// @brief Finds a characteristic of the client by its handle.
+NimBLERemoteCharacteristic* findCharacteristic(NimBLEClient* pClient, uint16_t handle);
+
+void setBonds(const std::vector<NimBLEAddress>& addresses);
+
+/// @brief Removes all peripherals, bonds and addresses on the accept list.
+void reset();
+
+}  // namespace host
@@ -0,0 +1,9 @@
+#pragma once
+
+#ifndef CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#define CONFIG_BT_NIMBLE_MAX_CONNECTIONS 3
+#endif
+
+#ifndef CONFIG_BT_NIMBLE_PINNED_TO_CORE
+#define CONFIG_BT_NIMBLE_PINNED_TO_CORE 0
+#endif
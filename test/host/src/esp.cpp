@@ -0,0 +1,61 @@
+#include <Esp.h>
+#include <esp_log.h>
+#include <cstdarg>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+
+EspClass ESP;
+
+const char* EspClass::getChipModel() {
+  return "Host";
+}
+
+namespace {
+
+struct LogState {
+  std::mutex mutex;
+  std::map<std::string, esp_log_level_t> levels;
+  esp_log_level_t defaultLevel{ESP_LOG_ERROR};
+};
+
+LogState& logState() {
+  static auto* pState = new LogState();
+  return *pState;
+}
+
+const char logLetters[] = {'N', 'E', 'W', 'I', 'D', 'V'};
+
+}  // namespace
+
+void esp_log_level_set(const char* tag, const esp_log_level_t level) {
+  auto& state = logState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (std::string(tag) == "*") {
+    state.defaultLevel = level;
+    state.levels.clear();
+    return;
+  }
+  state.levels[tag] = level;
+}
+
+esp_log_level_t esp_log_level_get(const char* tag) {
+  auto& state = logState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  const auto it = state.levels.find(tag);
+  return it != state.levels.end() ? it->second : state.defaultLevel;
+}
+
+void esp_log_write(const esp_log_level_t level, const char* tag, const char* format, ...) {
+  if (level == ESP_LOG_NONE || level > esp_log_level_get(tag)) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(logState().mutex);
+  fprintf(stderr, "%c (%s) ", logLetters[level < ESP_LOG_MAX ? level : ESP_LOG_VERBOSE], tag);
+  va_list args;
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+}
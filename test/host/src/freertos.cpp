@@ -0,0 +1,423 @@
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <freertos/timers.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "host.h"
+
+// Kernel objects stay allocated until the process exits, so that a task blocked on a deleted queue or a task that is
+// deleted while running never touches freed memory. Mutexes and timers are freed, deleting them while in use is a bug
+// on the device as well.
+
+struct HostTask {
+  std::mutex mutex;
+  std::condition_variable cv;
+  uint32_t notifyValue{0};
+  bool notifyPending{false};
+};
+
+struct HostQueue {
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t length;
+  size_t itemSize;
+  std::deque<std::vector<uint8_t>> items;
+};
+
+struct HostSemaphore {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool taken{false};
+  std::thread::id owner{};
+};
+
+struct HostTimer {
+  TickType_t periodTicks;
+  bool autoReload;
+  void* pTimerId;
+  TimerCallbackFunction_t callback;
+  bool active{false};
+  int64_t dueUs{0};
+};
+
+namespace {
+
+std::mutex& objectsMutex() {
+  static auto* pMutex = new std::mutex();
+  return *pMutex;
+}
+
+template <typename T>
+T* keepAlive(T* pObject) {
+  static auto* pObjects = new std::vector<std::shared_ptr<void>>();
+  std::lock_guard<std::mutex> lock(objectsMutex());
+  pObjects->emplace_back(pObject, [](void*) {});
+  return pObject;
+}
+
+thread_local HostTask* tlsCurrentTask = nullptr;
+
+int64_t realTimeUs() {
+  // kernel objects are created by static constructors of the library, so nothing here relies on static init order
+  static const auto startTime = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count() +
+         1;
+}
+
+// waits on the condition variable until the predicate holds or the ticks elapse
+template <typename Predicate>
+bool waitTicks(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, TickType_t ticks, Predicate pred) {
+  if (ticks == portMAX_DELAY) {
+    cv.wait(lock, pred);
+    return true;
+  }
+  return cv.wait_for(lock, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), pred);
+}
+
+}  // namespace
+
+void hostAssertFailed(const char* expr, const char* file, const int line) {
+  fprintf(stderr, "configASSERT(%s) failed at %s:%d\n", expr, file, line);
+  abort();
+}
+
+// tasks
+
+static BaseType_t createTask(TaskFunction_t pxTaskCode, void* pvParameters, TaskHandle_t* pxCreatedTask) {
+  auto* pTask = keepAlive(new HostTask());
+  if (pxCreatedTask) {
+    *pxCreatedTask = pTask;
+  }
+
+  std::thread([pTask, pxTaskCode, pvParameters]() {
+    tlsCurrentTask = pTask;
+    pxTaskCode(pvParameters);
+  }).detach();
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(const TaskFunction_t pxTaskCode,
+                       const char* pcName,
+                       const uint32_t usStackDepth,
+                       void* pvParameters,
+                       const UBaseType_t uxPriority,
+                       TaskHandle_t* pxCreatedTask) {
+  return createTask(pxTaskCode, pvParameters, pxCreatedTask);
+}
+
+BaseType_t xTaskCreatePinnedToCore(const TaskFunction_t pxTaskCode,
+                                   const char* pcName,
+                                   const uint32_t usStackDepth,
+                                   void* pvParameters,
+                                   const UBaseType_t uxPriority,
+                                   TaskHandle_t* pxCreatedTask,
+                                   const BaseType_t xCoreID) {
+  return createTask(pxTaskCode, pvParameters, pxCreatedTask);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+  // threads can't be stopped from the outside, a deleted task stays blocked where it is
+  configASSERT(xTaskToDelete != nullptr);
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(xTicksToDelay * portTICK_PERIOD_MS));
+}
+
+TickType_t xTaskGetTickCount() {
+  return static_cast<TickType_t>(realTimeUs() / 1000 / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  if (!tlsCurrentTask) {
+    tlsCurrentTask = keepAlive(new HostTask());
+  }
+  return tlsCurrentTask;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t xTaskToNotify, const uint32_t ulValue, const eNotifyAction eAction) {
+  configASSERT(xTaskToNotify != nullptr);
+
+  std::lock_guard<std::mutex> lock(xTaskToNotify->mutex);
+  switch (eAction) {
+    case eNoAction:
+      break;
+    case eSetBits:
+      xTaskToNotify->notifyValue |= ulValue;
+      break;
+    case eIncrement:
+      xTaskToNotify->notifyValue++;
+      break;
+    case eSetValueWithOverwrite:
+      xTaskToNotify->notifyValue = ulValue;
+      break;
+    case eSetValueWithoutOverwrite:
+      if (xTaskToNotify->notifyPending) {
+        return pdFAIL;
+      }
+      xTaskToNotify->notifyValue = ulValue;
+      break;
+  }
+  xTaskToNotify->notifyPending = true;
+  xTaskToNotify->cv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify) {
+  return xTaskNotify(xTaskToNotify, 0, eIncrement);
+}
+
+uint32_t ulTaskNotifyTake(const BaseType_t xClearCountOnExit, const TickType_t xTicksToWait) {
+  auto* pTask = xTaskGetCurrentTaskHandle();
+
+  std::unique_lock<std::mutex> lock(pTask->mutex);
+  waitTicks(pTask->cv, lock, xTicksToWait, [pTask]() { return pTask->notifyValue != 0; });
+  const auto value = pTask->notifyValue;
+  if (value != 0) {
+    pTask->notifyValue = xClearCountOnExit ? 0 : value - 1;
+  }
+  pTask->notifyPending = false;
+  return value;
+}
+
+// queues
+
+QueueHandle_t xQueueCreate(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize) {
+  auto* pQueue = keepAlive(new HostQueue());
+  pQueue->length = uxQueueLength;
+  pQueue->itemSize = uxItemSize;
+  return pQueue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue, const TickType_t xTicksToWait) {
+  configASSERT(xQueue != nullptr);
+
+  std::unique_lock<std::mutex> lock(xQueue->mutex);
+  if (!waitTicks(xQueue->cv, lock, xTicksToWait, [xQueue]() { return xQueue->items.size() < xQueue->length; })) {
+    return pdFAIL;
+  }
+
+  const auto* pItem = static_cast<const uint8_t*>(pvItemToQueue);
+  xQueue->items.emplace_back(pItem, pItem + xQueue->itemSize);
+  xQueue->cv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, const TickType_t xTicksToWait) {
+  configASSERT(xQueue != nullptr);
+
+  std::unique_lock<std::mutex> lock(xQueue->mutex);
+  if (!waitTicks(xQueue->cv, lock, xTicksToWait, [xQueue]() { return !xQueue->items.empty(); })) {
+    return pdFALSE;
+  }
+
+  memcpy(pvBuffer, xQueue->items.front().data(), xQueue->itemSize);
+  xQueue->items.pop_front();
+  xQueue->cv.notify_all();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue) {
+  std::lock_guard<std::mutex> lock(xQueue->mutex);
+  return xQueue->items.size();
+}
+
+void vQueueDelete(QueueHandle_t xQueue) {
+  configASSERT(xQueue != nullptr);
+}
+
+// mutexes
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new HostSemaphore();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, const TickType_t xBlockTime) {
+  configASSERT(xSemaphore != nullptr);
+
+  const auto self = std::this_thread::get_id();
+  std::unique_lock<std::mutex> lock(xSemaphore->mutex);
+  // FreeRTOS mutexes are not recursive, taking one twice without a timeout never returns
+  configASSERT(!(xSemaphore->taken && xSemaphore->owner == self && xBlockTime == portMAX_DELAY));
+  if (!waitTicks(xSemaphore->cv, lock, xBlockTime, [xSemaphore]() { return !xSemaphore->taken; })) {
+    return pdFALSE;
+  }
+
+  xSemaphore->taken = true;
+  xSemaphore->owner = self;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore) {
+  configASSERT(xSemaphore != nullptr);
+
+  std::lock_guard<std::mutex> lock(xSemaphore->mutex);
+  if (!xSemaphore->taken || xSemaphore->owner != std::this_thread::get_id()) {
+    return pdFALSE;
+  }
+
+  xSemaphore->taken = false;
+  xSemaphore->owner = std::thread::id();
+  xSemaphore->cv.notify_one();
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t xSemaphore) {
+  configASSERT(xSemaphore != nullptr);
+  delete xSemaphore;
+}
+
+// software timers
+
+namespace {
+
+struct TimerService {
+  std::recursive_mutex mutex;
+  std::vector<HostTimer*> timers;
+
+  TimerService() {
+    std::thread([this]() {
+      while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        host::fireTimers();
+      }
+    }).detach();
+  }
+};
+
+TimerService& timerService() {
+  static auto* pService = new TimerService();
+  return *pService;
+}
+
+}  // namespace
+
+TimerHandle_t xTimerCreate(const char* pcTimerName,
+                           const TickType_t xTimerPeriodInTicks,
+                           const UBaseType_t uxAutoReload,
+                           void* pvTimerID,
+                           const TimerCallbackFunction_t pxCallbackFunction) {
+  auto& service = timerService();
+  auto* pTimer = new HostTimer{xTimerPeriodInTicks, uxAutoReload != pdFALSE, pvTimerID, pxCallbackFunction};
+
+  std::lock_guard<std::recursive_mutex> lock(service.mutex);
+  service.timers.push_back(pTimer);
+  return pTimer;
+}
+
+BaseType_t xTimerStart(TimerHandle_t xTimer, const TickType_t xTicksToWait) {
+  configASSERT(xTimer != nullptr);
+
+  std::lock_guard<std::recursive_mutex> lock(timerService().mutex);
+  xTimer->active = true;
+  xTimer->dueUs = esp_timer_get_time() + static_cast<int64_t>(xTimer->periodTicks) * portTICK_PERIOD_MS * 1000;
+  return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t xTimer, const TickType_t xTicksToWait) {
+  configASSERT(xTimer != nullptr);
+
+  std::lock_guard<std::recursive_mutex> lock(timerService().mutex);
+  xTimer->active = false;
+  return pdPASS;
+}
+
+BaseType_t xTimerDelete(TimerHandle_t xTimer, const TickType_t xTicksToWait) {
+  configASSERT(xTimer != nullptr);
+
+  auto& service = timerService();
+  std::lock_guard<std::recursive_mutex> lock(service.mutex);
+  service.timers.erase(std::remove(service.timers.begin(), service.timers.end(), xTimer), service.timers.end());
+  delete xTimer;
+  return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t xTimer) {
+  std::lock_guard<std::recursive_mutex> lock(timerService().mutex);
+  return xTimer->active ? pdTRUE : pdFALSE;
+}
+
+void* pvTimerGetTimerID(TimerHandle_t xTimer) {
+  return xTimer->pTimerId;
+}
+
+namespace host {
+
+void fireTimers() {
+  auto& service = timerService();
+  std::lock_guard<std::recursive_mutex> lock(service.mutex);
+
+  const auto nowUs = esp_timer_get_time();
+  // callbacks may delete timers, so the list is walked by index
+  for (size_t i = 0; i < service.timers.size(); i++) {
+    auto* pTimer = service.timers[i];
+    if (!pTimer->active || pTimer->dueUs > nowUs) {
+      continue;
+    }
+
+    const int64_t periodUs = static_cast<int64_t>(pTimer->periodTicks) * portTICK_PERIOD_MS * 1000;
+    pTimer->active = pTimer->autoReload;
+    pTimer->dueUs = nowUs + periodUs;
+    pTimer->callback(pTimer);
+  }
+}
+
+}  // namespace host
+
+// clock
+
+namespace {
+
+std::atomic_bool manualClock{false};
+std::atomic<int64_t> manualTimeUs{0};
+
+}  // namespace
+
+int64_t esp_timer_get_time() {
+  return manualClock.load(std::memory_order_acquire) ? manualTimeUs.load(std::memory_order_acquire) : realTimeUs();
+}
+
+unsigned long millis() {
+  return static_cast<unsigned long>(esp_timer_get_time() / 1000);
+}
+
+unsigned long micros() {
+  return static_cast<unsigned long>(esp_timer_get_time());
+}
+
+void delay(const uint32_t ms) {
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+namespace host {
+
+void useManualClock(const int64_t startUs) {
+  manualTimeUs = startUs;
+  manualClock = true;
+}
+
+void useRealClock() {
+  manualClock = false;
+}
+
+void setTimeUs(const int64_t timeUs) {
+  manualTimeUs = timeUs;
+}
+
+void advanceTimeUs(const int64_t deltaUs) {
+  manualTimeUs += deltaUs;
+}
+
+}  // namespace host
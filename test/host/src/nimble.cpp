@@ -0,0 +1,769 @@
+#include <NimBLEDevice.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "host.h"
+
+// Every BLE event is delivered on a single host thread in the order it was posted, like the NimBLE host task does.
+
+namespace {
+
+struct HostTaskState {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::function<void()>> work;
+  bool busy{false};
+
+  HostTaskState() {
+    std::thread([this]() {
+      while (true) {
+        std::function<void()> fn;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cv.wait(lock, [this]() { return !work.empty(); });
+          fn = std::move(work.front());
+          work.pop_front();
+          busy = true;
+        }
+        fn();
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          busy = false;
+        }
+        cv.notify_all();
+      }
+    }).detach();
+  }
+};
+
+HostTaskState& hostTask() {
+  static auto* pState = new HostTaskState();
+  return *pState;
+}
+
+struct DeviceState {
+  std::recursive_mutex mutex;
+  bool initialized{false};
+  std::vector<std::shared_ptr<host::Peripheral>> peripherals;
+  std::vector<NimBLEAddress> bonds;
+  std::vector<NimBLEAddress> whiteList;
+  std::vector<NimBLEClient*> clients;
+};
+
+DeviceState& device() {
+  static auto* pState = new DeviceState();
+  return *pState;
+}
+
+NimBLEScan& scan() {
+  static auto* pScan = new NimBLEScan();
+  return *pScan;
+}
+
+int hexValue(const char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  const auto lower = static_cast<char>(tolower(c));
+  if (lower >= 'a' && lower <= 'f') {
+    return lower - 'a' + 10;
+  }
+  return -1;
+}
+
+}  // namespace
+
+// NimBLEAddress
+
+NimBLEAddress::NimBLEAddress() : ble_addr_t{} {}
+
+NimBLEAddress::NimBLEAddress(const uint64_t address, const uint8_t type) : ble_addr_t{} {
+  this->type = type;
+  for (size_t i = 0; i < BLE_DEV_ADDR_LEN; i++) {
+    val[i] = address >> (8 * i);
+  }
+}
+
+NimBLEAddress::NimBLEAddress(const std::string& address, const uint8_t type) : ble_addr_t{} {
+  this->type = type;
+  // most significant byte first, "aa:bb:cc:dd:ee:ff"
+  size_t byte = BLE_DEV_ADDR_LEN;
+  for (size_t i = 0; i + 1 < address.size() && byte > 0; i += 3) {
+    const auto hi = hexValue(address[i]);
+    const auto lo = hexValue(address[i + 1]);
+    if (hi < 0 || lo < 0) {
+      *this = NimBLEAddress();
+      return;
+    }
+    val[--byte] = hi << 4 | lo;
+  }
+}
+
+bool NimBLEAddress::isNull() const {
+  return static_cast<uint64_t>(*this) == 0;
+}
+
+bool NimBLEAddress::operator==(const NimBLEAddress& rhs) const {
+  return type == rhs.type && memcmp(val, rhs.val, BLE_DEV_ADDR_LEN) == 0;
+}
+
+NimBLEAddress::operator uint64_t() const {
+  uint64_t address = 0;
+  for (size_t i = BLE_DEV_ADDR_LEN; i-- > 0;) {
+    address = address << 8 | val[i];
+  }
+  return address;
+}
+
+NimBLEAddress::operator std::string() const {
+  char str[18];
+  snprintf(str, sizeof(str), "%02x:%02x:%02x:%02x:%02x:%02x", val[5], val[4], val[3], val[2], val[1], val[0]);
+  return str;
+}
+
+// NimBLEUUID
+
+NimBLEUUID::NimBLEUUID(const uint16_t uuid16) : _bitSize(16), _uuid16(uuid16) {}
+
+NimBLEUUID::NimBLEUUID(const std::string& uuid) {
+  if (uuid.size() == 4 || (uuid.size() == 6 && uuid[0] == '0' && (uuid[1] == 'x' || uuid[1] == 'X'))) {
+    _bitSize = 16;
+    _uuid16 = static_cast<uint16_t>(std::stoul(uuid, nullptr, 16));
+    return;
+  }
+  if (uuid.size() == 36) {
+    _bitSize = 128;
+    _uuid128 = uuid;
+    std::transform(_uuid128.begin(), _uuid128.end(), _uuid128.begin(), [](char c) { return tolower(c); });
+  }
+}
+
+NimBLEUUID::NimBLEUUID(const char* uuid) : NimBLEUUID(std::string(uuid)) {}
+
+bool NimBLEUUID::operator==(const NimBLEUUID& rhs) const {
+  return std::string(*this) == std::string(rhs);
+}
+
+NimBLEUUID::operator std::string() const {
+  if (_bitSize == 16) {
+    char str[7];
+    snprintf(str, sizeof(str), "0x%04x", _uuid16);
+    return str;
+  }
+  return _uuid128;
+}
+
+// NimBLEUtils
+
+const char* NimBLEUtils::returnCodeToString(const int rc) {
+  switch (rc) {
+    case 0:
+      return "Success";
+    case BLE_HS_ENOTCONN:
+      return "BLE_HS_ENOTCONN";
+    case BLE_HS_ETIMEOUT:
+      return "BLE_HS_ETIMEOUT";
+    default:
+      return "Unknown";
+  }
+}
+
+// NimBLEAdvertisedDevice
+
+NimBLEAdvertisedDevice::NimBLEAdvertisedDevice(const NimBLEAddress& address, std::vector<uint8_t> payload)
+    : _address(address), _payload(std::move(payload)) {}
+
+size_t NimBLEAdvertisedDevice::_findType(const uint16_t type, uint8_t index, size_t* pDataLen) const {
+  size_t pos = 0;
+  while (pos + 1 < _payload.size()) {
+    const uint8_t fieldLen = _payload[pos];
+    if (fieldLen == 0 || pos + 1 + fieldLen > _payload.size()) {
+      break;
+    }
+    if (_payload[pos + 1] == type && index-- == 0) {
+      *pDataLen = fieldLen - 1;
+      return pos + 2;
+    }
+    pos += 1 + fieldLen;
+  }
+  return 0;
+}
+
+bool NimBLEAdvertisedDevice::haveType(const uint16_t type) const {
+  size_t dataLen;
+  return _findType(type, 0, &dataLen) != 0;
+}
+
+std::string NimBLEAdvertisedDevice::getPayloadByType(const uint16_t type, const uint8_t index) const {
+  size_t dataLen = 0;
+  const auto pos = _findType(type, index, &dataLen);
+  if (pos == 0) {
+    return "";
+  }
+  return {reinterpret_cast<const char*>(&_payload[pos]), dataLen};
+}
+
+// NimBLEScan
+
+void NimBLEScan::setScanCallbacks(NimBLEScanCallbacks* pScanCallbacks, bool wantDuplicates) {
+  _pCallbacks = pScanCallbacks;
+}
+
+bool NimBLEScan::start(const uint32_t durationMs, bool isContinue, bool restart) {
+  _durationMs = durationMs;
+  _startUs = esp_timer_get_time();
+  _startCount++;
+  _scanning = true;
+  return true;
+}
+
+bool NimBLEScan::stop() {
+  // like NimBLE, a scan stopped by the application doesn't report its end
+  _scanning = false;
+  return true;
+}
+
+bool NimBLEScan::deliver(const NimBLEAdvertisedDevice* pAdvertisedDevice) {
+  // scan results are reported on the host task, so a connection started by the callback completes after it returns
+  bool delivered = false;
+  host::post([this, pAdvertisedDevice, &delivered]() {
+    if (!_scanning) {
+      return;
+    }
+    if (_filterPolicy == BLE_HCI_SCAN_FILT_USE_WL && !NimBLEDevice::onWhiteList(pAdvertisedDevice->getAddress())) {
+      return;
+    }
+
+    delivered = true;
+    if (_pCallbacks) {
+      _pCallbacks->onDiscovered(pAdvertisedDevice);
+      _pCallbacks->onResult(pAdvertisedDevice);
+    }
+  });
+  host::waitIdle();
+  return delivered;
+}
+
+void NimBLEScan::end(const int reason) {
+  host::post([this, reason]() {
+    if (_scanning.exchange(false) && _pCallbacks) {
+      _pCallbacks->onScanEnd(NimBLEScanResults(), reason);
+    }
+  });
+  host::waitIdle();
+}
+
+static void attRoundTrip(const NimBLEClient* pClient) {
+  const auto pPeripheral = pClient ? pClient->getPeripheral() : nullptr;
+  if (!pPeripheral) {
+    return;
+  }
+  pPeripheral->attRequests++;
+  host::advanceTimeUs(pPeripheral->attRoundTripUs);
+}
+
+// NimBLERemoteDescriptor
+
+NimBLERemoteDescriptor::NimBLERemoteDescriptor(const NimBLEUUID& uuid, std::vector<uint8_t> value)
+    : _uuid(uuid), _value(std::move(value)) {}
+
+NimBLEAttValue NimBLERemoteDescriptor::readValue() {
+  return NimBLEAttValue(_value);
+}
+
+// NimBLERemoteCharacteristic
+
+NimBLERemoteCharacteristic::NimBLERemoteCharacteristic(const NimBLEUUID& uuid,
+                                                       const uint16_t handle,
+                                                       const uint8_t properties,
+                                                       NimBLEClient* pClient,
+                                                       const NimBLERemoteService* pService)
+    : _uuid(uuid),
+      _handle(handle),
+      _properties(properties),
+      _pClient(pClient),
+      _pService(pService),
+      _subscribed(false),
+      _readCount(0) {}
+
+NimBLERemoteDescriptor* NimBLERemoteCharacteristic::getDescriptor(const NimBLEUUID& uuid) const {
+  for (const auto& pDsc : _descriptors) {
+    if (pDsc->getUUID() == uuid) {
+      return pDsc.get();
+    }
+  }
+  return nullptr;
+}
+
+bool NimBLERemoteCharacteristic::subscribe(const bool notifications,
+                                           const notify_callback& notifyCallback,
+                                           bool response) {
+  if (notifications ? !canNotify() : !canIndicate()) {
+    return false;
+  }
+  _notifyCallback = notifyCallback;
+  _subscribed = true;
+  return true;
+}
+
+bool NimBLERemoteCharacteristic::unsubscribe(bool response) {
+  _subscribed = false;
+  _notifyCallback = nullptr;
+  return true;
+}
+
+NimBLEAttValue NimBLERemoteCharacteristic::readValue() {
+  attRoundTrip(_pClient);
+  _readCount++;
+  return NimBLEAttValue(_value);
+}
+
+bool NimBLERemoteCharacteristic::writeValue(const uint8_t* data, const size_t length, bool response) const {
+  if (response) {
+    attRoundTrip(_pClient);
+  }
+  std::lock_guard<std::mutex> lock(_writesMutex);
+  _writes.emplace_back(data, data + length);
+  return true;
+}
+
+void NimBLERemoteCharacteristic::setValue(std::vector<uint8_t> value) {
+  _value = std::move(value);
+}
+
+void NimBLERemoteCharacteristic::addDescriptor(const NimBLEUUID& uuid, std::vector<uint8_t> value) {
+  _descriptors.emplace_back(new NimBLERemoteDescriptor(uuid, std::move(value)));
+}
+
+bool NimBLERemoteCharacteristic::isSubscribed() const {
+  return _subscribed;
+}
+
+void NimBLERemoteCharacteristic::notify(const uint8_t* data, const size_t length) {
+  if (!_subscribed || !_notifyCallback) {
+    return;
+  }
+  // the host passes a buffer it owns, the receiver must copy the data
+  std::vector<uint8_t> buffer(data, data + length);
+  _notifyCallback(this, buffer.data(), buffer.size(), true);
+}
+
+std::vector<std::vector<uint8_t>> NimBLERemoteCharacteristic::getWrites() const {
+  std::lock_guard<std::mutex> lock(_writesMutex);
+  return _writes;
+}
+
+// NimBLERemoteService
+
+NimBLERemoteService::NimBLERemoteService(const NimBLEUUID& uuid, const uint16_t handle)
+    : _uuid(uuid), _handle(handle) {}
+
+NimBLERemoteCharacteristic* NimBLERemoteService::getCharacteristic(const NimBLEUUID& uuid) const {
+  for (auto* pChar : _characteristics) {
+    if (pChar->getUUID() == uuid) {
+      return pChar;
+    }
+  }
+  return nullptr;
+}
+
+const std::vector<NimBLERemoteCharacteristic*>& NimBLERemoteService::getCharacteristics(bool refresh) const {
+  return _characteristics;
+}
+
+NimBLERemoteCharacteristic* NimBLERemoteService::addCharacteristic(std::unique_ptr<NimBLERemoteCharacteristic> pChar) {
+  _characteristics.push_back(pChar.get());
+  _owned.push_back(std::move(pChar));
+  return _characteristics.back();
+}
+
+// NimBLEClient
+
+NimBLEClient::NimBLEClient(const NimBLEAddress& peerAddress)
+    : _peerAddress(peerAddress),
+      _pPeripheral(host::findPeripheral(peerAddress)),
+      _pCallbacks(nullptr),
+      _connectTimeoutMs(30000),
+      _connecting(false),
+      _connected(false) {}
+
+NimBLEClient::~NimBLEClient() = default;
+
+bool NimBLEClient::connect(bool deleteAttributes, bool asyncConnect, bool exchangeMTU) {
+  if (_connecting || _connected) {
+    return false;
+  }
+
+  scan().stop();
+  _connecting = true;
+  host::post([this]() {
+    if (!_connecting.exchange(false)) {
+      return;  // canceled
+    }
+    if (!_pPeripheral || !_pPeripheral->acceptsConnection) {
+      if (_pCallbacks) {
+        _pCallbacks->onConnectFail(this, BLE_HS_ETIMEOUT);
+      }
+      return;
+    }
+    _onConnected();
+  });
+  return true;
+}
+
+bool NimBLEClient::disconnect(uint8_t reason) {
+  if (!_connected) {
+    return false;
+  }
+  host::post([this, reason]() {
+    if (_connected) {
+      _onDisconnected(0x200 | reason);
+    }
+  });
+  return true;
+}
+
+bool NimBLEClient::cancelConnect() const {
+  auto* self = const_cast<NimBLEClient*>(this);
+  if (!self->_connecting.exchange(false)) {
+    return false;
+  }
+  host::post([self]() {
+    if (self->_pCallbacks) {
+      self->_pCallbacks->onConnectFail(self, BLE_HS_ENOTCONN);
+    }
+  });
+  return true;
+}
+
+bool NimBLEClient::isConnected() const {
+  return _connected;
+}
+
+bool NimBLEClient::secureConnection(bool async) const {
+  if (!_connected) {
+    return false;
+  }
+  auto* self = const_cast<NimBLEClient*>(this);
+  host::post([self]() {
+    if (!self->_connected) {
+      return;
+    }
+    NimBLEConnInfo connInfo;
+    {
+      std::lock_guard<std::mutex> lock(self->_connInfoMutex);
+      self->_connInfo.bonded = self->_pPeripheral->bonds;
+      self->_connInfo.encrypted = self->_pPeripheral->bonds;
+      connInfo = self->_connInfo;
+    }
+    if (connInfo.bonded) {
+      auto& state = device();
+      std::lock_guard<std::recursive_mutex> lock(state.mutex);
+      if (std::find(state.bonds.begin(), state.bonds.end(), self->_peerAddress) == state.bonds.end()) {
+        state.bonds.push_back(self->_peerAddress);
+      }
+    }
+    if (self->_pCallbacks) {
+      self->_pCallbacks->onAuthenticationComplete(connInfo);
+    }
+  });
+  return true;
+}
+
+void NimBLEClient::setClientCallbacks(NimBLEClientCallbacks* pClientCallbacks, bool deleteCallbacks) {
+  _pCallbacks = pClientCallbacks;
+}
+
+NimBLERemoteService* NimBLEClient::getService(const NimBLEUUID& uuid) {
+  for (auto* pSvc : _services) {
+    if (pSvc->getUUID() == uuid) {
+      return pSvc;
+    }
+  }
+  return nullptr;
+}
+
+const std::vector<NimBLERemoteService*>& NimBLEClient::getServices(bool refresh) {
+  return _services;
+}
+
+bool NimBLEClient::updateConnParams(const uint16_t minInterval,
+                                    const uint16_t maxInterval,
+                                    const uint16_t latency,
+                                    const uint16_t timeout) {
+  if (!_connected) {
+    return false;
+  }
+  _pPeripheral->connParamsRequests++;
+  host::post([this, maxInterval, latency, timeout]() {
+    if (!_connected || !_pPeripheral->acceptsConnParams) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(_connInfoMutex);
+      _connInfo.connInterval = maxInterval;
+      _connInfo.connLatency = latency;
+      _connInfo.connTimeout = timeout;
+    }
+    if (_pCallbacks) {
+      _pCallbacks->onConnParamsUpdate(this);
+    }
+  });
+  return true;
+}
+
+NimBLEConnInfo NimBLEClient::getConnInfo() const {
+  std::lock_guard<std::mutex> lock(_connInfoMutex);
+  return _connInfo;
+}
+
+void NimBLEClient::_onConnected() {
+  _owned.clear();
+  _services.clear();
+  for (const auto& svcSpec : _pPeripheral->services) {
+    auto* pSvc = new NimBLERemoteService(svcSpec.uuid, svcSpec.characteristics.empty()
+                                                           ? 1
+                                                           : svcSpec.characteristics.front().handle - 1);
+    _owned.emplace_back(pSvc);
+    _services.push_back(pSvc);
+    for (const auto& charSpec : svcSpec.characteristics) {
+      auto* pChar = pSvc->addCharacteristic(std::unique_ptr<NimBLERemoteCharacteristic>(
+          new NimBLERemoteCharacteristic(charSpec.uuid, charSpec.handle, charSpec.properties, this, pSvc)));
+      pChar->setValue(charSpec.value);
+      for (const auto& dscSpec : charSpec.descriptors) {
+        pChar->addDescriptor(dscSpec.first, dscSpec.second);
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_connInfoMutex);
+    _connInfo = NimBLEConnInfo();
+    _connInfo.address = _peerAddress;
+    _connInfo.connHandle = 1;
+    _connInfo.connInterval = _pPeripheral->connInterval;
+    _connInfo.connLatency = _pPeripheral->connLatency;
+    _connInfo.connTimeout = _pPeripheral->connTimeout;
+  }
+
+  _pPeripheral->connects++;
+  _connected = true;
+  if (_pCallbacks) {
+    _pCallbacks->onConnect(this);
+  }
+}
+
+void NimBLEClient::_onDisconnected(const int reason) {
+  _connected = false;
+  for (auto* pSvc : _services) {
+    for (auto* pChar : pSvc->getCharacteristics()) {
+      pChar->unsubscribe();
+    }
+  }
+  if (_pCallbacks) {
+    _pCallbacks->onDisconnect(this, reason);
+  }
+}
+
+// NimBLEDevice
+
+bool NimBLEDevice::init(const std::string& deviceName) {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  state.initialized = true;
+  return true;
+}
+
+bool NimBLEDevice::deinit(bool clearAll) {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  state.initialized = false;
+  return true;
+}
+
+bool NimBLEDevice::isInitialized() {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  return state.initialized;
+}
+
+bool NimBLEDevice::deleteAllBonds() {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  state.bonds.clear();
+  return true;
+}
+
+int NimBLEDevice::getNumBonds() {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  return static_cast<int>(state.bonds.size());
+}
+
+NimBLEAddress NimBLEDevice::getBondedAddress(const int index) {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  return index < static_cast<int>(state.bonds.size()) ? state.bonds[index] : NimBLEAddress();
+}
+
+NimBLEScan* NimBLEDevice::getScan() {
+  return &scan();
+}
+
+NimBLEClient* NimBLEDevice::createClient(const NimBLEAddress& peerAddress) {
+  auto* pClient = new NimBLEClient(peerAddress);
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  state.clients.push_back(pClient);
+  return pClient;
+}
+
+bool NimBLEDevice::deleteClient(NimBLEClient* pClient) {
+  if (!pClient || pClient->isConnected()) {
+    return false;
+  }
+
+  {
+    auto& state = device();
+    std::lock_guard<std::recursive_mutex> lock(state.mutex);
+    state.clients.erase(std::remove(state.clients.begin(), state.clients.end(), pClient), state.clients.end());
+  }
+  // events already posted for the client run before it is deleted
+  host::post([pClient]() { delete pClient; });
+  return true;
+}
+
+bool NimBLEDevice::whiteListAdd(const NimBLEAddress& address) {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  if (!onWhiteList(address)) {
+    state.whiteList.push_back(address);
+  }
+  return true;
+}
+
+bool NimBLEDevice::whiteListRemove(const NimBLEAddress& address) {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  const auto it = std::find(state.whiteList.begin(), state.whiteList.end(), address);
+  if (it == state.whiteList.end()) {
+    return false;
+  }
+  state.whiteList.erase(it);
+  return true;
+}
+
+bool NimBLEDevice::onWhiteList(const NimBLEAddress& address) {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  return std::find(state.whiteList.begin(), state.whiteList.end(), address) != state.whiteList.end();
+}
+
+size_t NimBLEDevice::getWhiteListCount() {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  return state.whiteList.size();
+}
+
+NimBLEAddress NimBLEDevice::getWhiteListAddress(const size_t index) {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  return index < state.whiteList.size() ? state.whiteList[index] : NimBLEAddress();
+}
+
+// host control
+
+namespace host {
+
+void post(std::function<void()> fn) {
+  auto& task = hostTask();
+  {
+    std::lock_guard<std::mutex> lock(task.mutex);
+    task.work.push_back(std::move(fn));
+  }
+  task.cv.notify_all();
+}
+
+void waitIdle() {
+  auto& task = hostTask();
+  std::unique_lock<std::mutex> lock(task.mutex);
+  task.cv.wait(lock, [&task]() { return task.work.empty() && !task.busy; });
+}
+
+bool waitFor(const std::function<bool()>& condition, const uint32_t timeoutMs) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+std::shared_ptr<Peripheral> addPeripheral(const NimBLEAddress& address, std::vector<ServiceSpec> services) {
+  auto pPeripheral = std::make_shared<Peripheral>();
+  pPeripheral->address = address;
+  pPeripheral->services = std::move(services);
+
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  state.peripherals.push_back(pPeripheral);
+  return pPeripheral;
+}
+
+std::shared_ptr<Peripheral> findPeripheral(const NimBLEAddress& address) {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  for (const auto& pPeripheral : state.peripherals) {
+    if (pPeripheral->address == address) {
+      return pPeripheral;
+    }
+  }
+  return nullptr;
+}
+
+NimBLEClient* findClient(const NimBLEAddress& address) {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  for (auto* pClient : state.clients) {
+    if (pClient->getPeerAddress() == address) {
+      return pClient;
+    }
+  }
+  return nullptr;
+}
+
+NimBLERemoteCharacteristic* findCharacteristic(NimBLEClient* pClient, const uint16_t handle) {
+  for (auto* pSvc : pClient->getServices()) {
+    for (auto* pChar : pSvc->getCharacteristics()) {
+      if (pChar->getHandle() == handle) {
+        return pChar;
+      }
+    }
+  }
+  return nullptr;
+}
+
+void setBonds(const std::vector<NimBLEAddress>& addresses) {
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  state.bonds = addresses;
+}
+
+void reset() {
+  waitIdle();
+  auto& state = device();
+  std::lock_guard<std::recursive_mutex> lock(state.mutex);
+  state.peripherals.clear();
+  state.bonds.clear();
+  state.whiteList.clear();
+}
+
+}  // namespace host
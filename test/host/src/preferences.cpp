@@ -0,0 +1,89 @@
+#include <Preferences.h>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+std::mutex storageMutex;
+// namespace -> key -> value
+std::map<std::string, std::map<std::string, std::vector<uint8_t>>> storage;
+
+}  // namespace
+
+bool Preferences::begin(const char* name, const bool readOnly, const char* partitionLabel) {
+  if (_started || !name || strlen(name) > 15) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(storageMutex);
+  // like NVS, a namespace that was never written can't be opened read only
+  if (readOnly && storage.find(name) == storage.end()) {
+    return false;
+  }
+  storage[name];
+  _name = name;
+  _readOnly = readOnly;
+  _started = true;
+  return true;
+}
+
+void Preferences::end() {
+  _started = false;
+}
+
+bool Preferences::isKey(const char* key) {
+  std::lock_guard<std::mutex> lock(storageMutex);
+  return _started && storage[_name].count(key) != 0;
+}
+
+bool Preferences::remove(const char* key) {
+  std::lock_guard<std::mutex> lock(storageMutex);
+  return _started && !_readOnly && storage[_name].erase(key) != 0;
+}
+
+bool Preferences::clear() {
+  std::lock_guard<std::mutex> lock(storageMutex);
+  if (!_started || _readOnly) {
+    return false;
+  }
+  storage[_name].clear();
+  return true;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, const size_t len) {
+  // NVS keys are at most 15 characters long
+  if (!_started || _readOnly || !key || strlen(key) > 15) {
+    return 0;
+  }
+
+  std::lock_guard<std::mutex> lock(storageMutex);
+  const auto* pValue = static_cast<const uint8_t*>(value);
+  storage[_name][key].assign(pValue, pValue + len);
+  return len;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  std::lock_guard<std::mutex> lock(storageMutex);
+  if (!_started) {
+    return 0;
+  }
+  const auto& values = storage[_name];
+  const auto it = values.find(key);
+  return it != values.end() ? it->second.size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, const size_t maxLen) {
+  std::lock_guard<std::mutex> lock(storageMutex);
+  if (!_started) {
+    return 0;
+  }
+  const auto& values = storage[_name];
+  const auto it = values.find(key);
+  if (it == values.end() || it->second.size() > maxLen) {
+    return 0;
+  }
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
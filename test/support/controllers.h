@@ -0,0 +1,44 @@
+#pragma once
+
+// Helpers for tests that connect controllers through the host stand-in of NimBLE.
+
+#include <BLEGamepadClient.h>
+#include <string>
+#include <vector>
+#include "host.h"
+
+namespace controllers {
+
+/// @brief Returns a controller instance that lives until the process exits. The library keeps registered controllers
+/// in static state, so tests reuse instances instead of destroying them while the library may still use them.
+template <typename T, size_t N = 0>
+T& instance() {
+  static auto* pCtrl = new T();
+  return *pCtrl;
+}
+
+/// @brief Delivers the advertisement until the controller connects. Scans are started asynchronously by the auto scan
+/// task, so the first advertisements may be delivered before a scan runs.
+template <typename T>
+bool connect(T& ctrl, const NimBLEAddress& address, const std::vector<uint8_t>& advertisement,
+             const uint32_t timeoutMs = 5000) {
+  NimBLEAdvertisedDevice adv(address, advertisement);
+  return host::waitFor(
+      [&]() {
+        NimBLEDevice::getScan()->deliver(&adv);
+        return ctrl.isConnected();
+      },
+      timeoutMs);
+}
+
+/// @brief Disconnects the controller and waits until it can be allocated again.
+template <typename T>
+bool disconnect(T& ctrl) {
+  ctrl.disconnect();
+  const auto disconnected = host::waitFor(
+      [&]() { return !ctrl.isConnected() && !ctrl.isConnecting() && ctrl.getAddress().isNull(); });
+  host::waitIdle();
+  return disconnected;
+}
+
+}  // namespace controllers
@@ -0,0 +1,81 @@
+#pragma once
+
+// GATT layouts and advertisements of the supported controllers, for the host stand-in of NimBLE.
+
+#include <NimBLEDevice.h>
+#include <string>
+#include <vector>
+#include "host.h"
+
+namespace peripherals {
+
+constexpr uint16_t xboxControlsHandle = 0x20;
+constexpr uint16_t xboxVibrationsHandle = 0x24;
+constexpr uint16_t xboxBatteryHandle = 0x40;
+constexpr uint16_t steamSettingsHandle = 0x50;
+constexpr uint16_t steamControlsHandle = 0x2c;
+
+constexpr uint8_t read = BLE_GATT_CHR_PROP_READ;
+constexpr uint8_t notify = BLE_GATT_CHR_PROP_READ | BLE_GATT_CHR_PROP_NOTIFY;
+constexpr uint8_t write = BLE_GATT_CHR_PROP_READ | BLE_GATT_CHR_PROP_WRITE | BLE_GATT_CHR_PROP_WRITE_NO_RSP;
+
+inline std::vector<uint8_t> bytes(const std::string& str) {
+  return {str.begin(), str.end()};
+}
+
+inline host::ServiceSpec deviceInfoService(const std::string& modelName) {
+  return {NimBLEUUID(static_cast<uint16_t>(0x180a)),
+          {
+              {NimBLEUUID(static_cast<uint16_t>(0x2a29)), 0x02, read, bytes("Host")},
+              {NimBLEUUID(static_cast<uint16_t>(0x2a24)), 0x04, read, bytes(modelName)},
+              {NimBLEUUID(static_cast<uint16_t>(0x2a50)), 0x06, read, {0x02, 0x5e, 0x04, 0x20, 0x0b, 0x01, 0x05}},
+          }};
+}
+
+inline std::vector<host::ServiceSpec> xbox() {
+  return {
+      deviceInfoService("Xbox Wireless Controller"),
+      {NimBLEUUID(static_cast<uint16_t>(0x1812)),
+       {
+           {NimBLEUUID(static_cast<uint16_t>(0x2a4b)), 0x1c, read, {0x05, 0x01, 0x09, 0x05, 0xa1, 0x01, 0xc0}},
+           {NimBLEUUID(static_cast<uint16_t>(0x2a4d)), xboxControlsHandle, notify},
+           {NimBLEUUID(static_cast<uint16_t>(0x2a4d)), xboxVibrationsHandle, write},
+       }},
+      {NimBLEUUID(static_cast<uint16_t>(0x180f)),
+       {
+           {NimBLEUUID(static_cast<uint16_t>(0x2a19)), xboxBatteryHandle, notify, {100}},
+       }},
+  };
+}
+
+inline std::vector<host::ServiceSpec> steam() {
+  return {
+      deviceInfoService("SteamController"),
+      {NimBLEUUID(static_cast<uint16_t>(0x1812)),
+       {
+           {NimBLEUUID(static_cast<uint16_t>(0x2a4b)), 0x1c, read, {0x06, 0x00, 0xff, 0x09, 0x01, 0xa1, 0x01, 0xc0}},
+           {NimBLEUUID(static_cast<uint16_t>(0x2a4d)), 0x24, notify},
+           {NimBLEUUID(static_cast<uint16_t>(0x2a4d)), 0x28, notify},
+           {NimBLEUUID(static_cast<uint16_t>(0x2a4d)), steamControlsHandle, notify},
+       }},
+      {NimBLEUUID("100f6c32-1735-4313-b402-38567131e5f3"),
+       {
+           {NimBLEUUID("100f6c34-1735-4313-b402-38567131e5f3"), steamSettingsHandle, write},
+       }},
+  };
+}
+
+/// @brief Advertisement payload with the complete local name.
+inline std::vector<uint8_t> namedAdvertisement(const std::string& name) {
+  std::vector<uint8_t> payload{0x02, BLE_HS_ADV_TYPE_FLAGS, 0x06};
+  payload.push_back(static_cast<uint8_t>(name.size() + 1));
+  payload.push_back(BLE_HS_ADV_TYPE_COMP_NAME);
+  payload.insert(payload.end(), name.begin(), name.end());
+  return payload;
+}
+
+inline NimBLEAddress address(const uint8_t last) {
+  return {0xc0ffee000000ull | last, BLE_ADDR_RANDOM};
+}
+
+}  // namespace peripherals
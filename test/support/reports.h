@@ -0,0 +1,90 @@
+#pragma once
+
+// Builders of the reports sent by the supported controllers.
+
+#include <cstdint>
+#include <vector>
+
+namespace reports {
+
+constexpr uint16_t steamButtons = 0x0010;
+constexpr uint16_t steamTriggers = 0x0020;
+constexpr uint16_t steamStick = 0x0080;
+constexpr uint16_t steamLeftPad = 0x0100;
+constexpr uint16_t steamRightPad = 0x0200;
+
+inline void putUInt16(std::vector<uint8_t>& report, const uint16_t val) {
+  report.push_back(val & 0xff);
+  report.push_back(val >> 8);
+}
+
+struct Xbox {
+  uint16_t leftStickX{0x8000};
+  uint16_t leftStickY{0x8000};
+  uint16_t rightStickX{0x8000};
+  uint16_t rightStickY{0x8000};
+  uint16_t leftTrigger{0};
+  uint16_t rightTrigger{0};
+  uint8_t dpad{0};
+  uint8_t buttons[3]{};
+
+  std::vector<uint8_t> build() const {
+    std::vector<uint8_t> report;
+    putUInt16(report, leftStickX);
+    putUInt16(report, leftStickY);
+    putUInt16(report, rightStickX);
+    putUInt16(report, rightStickY);
+    putUInt16(report, leftTrigger);
+    putUInt16(report, rightTrigger);
+    report.push_back(dpad);
+    report.insert(report.end(), buttons, buttons + 3);
+    return report;
+  }
+};
+
+/// @brief Steam Controller input report with the sections set in `contentInfo`, padded to the 19 bytes the controller
+/// sends.
+struct Steam {
+  uint16_t contentInfo{steamButtons};
+  uint8_t buttons[3]{};
+  uint8_t leftTrigger{0};
+  uint8_t rightTrigger{0};
+  int16_t stickX{0};
+  int16_t stickY{0};
+  int16_t leftPadX{0};
+  int16_t leftPadY{0};
+  int16_t rightPadX{0};
+  int16_t rightPadY{0};
+
+  std::vector<uint8_t> build() const {
+    std::vector<uint8_t> report{0xc0};
+    putUInt16(report, contentInfo | 0x04);
+    if (contentInfo & steamButtons) {
+      report.insert(report.end(), buttons, buttons + 3);
+    }
+    if (contentInfo & steamTriggers) {
+      report.push_back(leftTrigger);
+      report.push_back(rightTrigger);
+    }
+    if (contentInfo & steamStick) {
+      putUInt16(report, stickX);
+      putUInt16(report, stickY);
+    }
+    if (contentInfo & steamLeftPad) {
+      putUInt16(report, leftPadX);
+      putUInt16(report, leftPadY);
+    }
+    if (contentInfo & steamRightPad) {
+      putUInt16(report, rightPadX);
+      putUInt16(report, rightPadY);
+    }
+    report.resize(19, 0);
+    return report;
+  }
+};
+
+inline std::vector<uint8_t> xboxBattery(const uint8_t level) {
+  return {level};
+}
+
+}  // namespace reports
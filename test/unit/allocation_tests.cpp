@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <BLEGamepadClient.h>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+#include "controllers.h"
+#include "host.h"
+#include "peripherals.h"
+
+// Counts the heap allocations made by the thread that enabled counting, while it passes advertisements to the scan
+// callbacks. Allocations of the host stand-ins on other threads are not counted.
+
+static thread_local bool countAllocations = false;
+static thread_local size_t allocationCount = 0;
+
+void* operator new(const size_t size) {
+  if (countAllocations) {
+    allocationCount++;
+  }
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+static constexpr size_t advertisementCount = 10000;
+
+// Advertisements of unknown devices, of other controllers than the registered ones, of the connected controller and
+// of controllers of the registered type that can't be allocated because no controller is free.
+static std::vector<std::unique_ptr<NimBLEAdvertisedDevice>> syntheticAdvertisements(const NimBLEAddress& connected) {
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::vector<std::unique_ptr<NimBLEAdvertisedDevice>> advertisements;
+  advertisements.reserve(advertisementCount);
+
+  for (size_t i = 0; i < advertisementCount; i++) {
+    const auto address = NimBLEAddress(0xa00000000000ull | i, i % 2 ? BLE_ADDR_RANDOM : BLE_ADDR_PUBLIC);
+    std::vector<uint8_t> payload;
+    switch (i % 5) {
+      case 0:
+        payload = peripherals::namedAdvertisement("Device " + std::to_string(byte(rng)));
+        break;
+      case 1:
+        payload = peripherals::namedAdvertisement("SteamController");
+        break;
+      case 2:
+        payload = {0x02, BLE_HS_ADV_TYPE_FLAGS, 0x06, 0x03, BLE_HS_ADV_TYPE_APPEARANCE, 0xc4, 0x03, 0x05,
+                   BLE_HS_ADV_TYPE_MFG_DATA, static_cast<uint8_t>(byte(rng)), static_cast<uint8_t>(byte(rng)),
+                   0x01, 0x02, 0x03, BLE_HS_ADV_TYPE_COMP_UUIDS16, 0x12, 0x18};
+        break;
+      case 3:
+        payload = peripherals::namedAdvertisement("Xbox Wireless Controller");
+        break;
+      default:
+        advertisements.push_back(std::make_unique<NimBLEAdvertisedDevice>(
+            connected, peripherals::namedAdvertisement("Xbox Wireless Controller")));
+        continue;
+    }
+    // random trailing bytes, including truncated fields
+    for (int j = byte(rng) % 8; j > 0; j--) {
+      payload.push_back(static_cast<uint8_t>(byte(rng)));
+    }
+    advertisements.push_back(std::make_unique<NimBLEAdvertisedDevice>(address, payload));
+  }
+
+  return advertisements;
+}
+
+TEST(AllocationTest, HandlesAdvertisementsWithoutAllocating) {
+  host::reset();
+  auto& ctrl = controllers::instance<XboxController>();
+  ctrl.begin();
+
+  const auto address = peripherals::address(1);
+  host::addPeripheral(address, peripherals::xbox());
+  ASSERT_TRUE(controllers::connect(ctrl, address, peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  host::waitIdle();
+
+  const auto advertisements = syntheticAdvertisements(address);
+  auto* pCallbacks = NimBLEDevice::getScan()->getScanCallbacks();
+  ASSERT_NE(pCallbacks, nullptr);
+
+  countAllocations = true;
+  for (const auto& pAdvertisement : advertisements) {
+    pCallbacks->onResult(pAdvertisement.get());
+  }
+  countAllocations = false;
+
+  EXPECT_EQ(allocationCount, 0u);
+  EXPECT_TRUE(ctrl.isConnected());
+  EXPECT_EQ(ctrl.getAddress(), address);
+
+  ASSERT_TRUE(controllers::disconnect(ctrl));
+}
+
+// The advertisement that allocates a free controller creates a client to connect it, which allocates on the device
+// as well. Every other advertisement, including those handled after the controller was allocated, allocates nothing.
+TEST(AllocationTest, AllocatesOnlyTheClientOfAFreeController) {
+  host::reset();
+  auto& ctrl = controllers::instance<XboxController>();
+  auto& freeCtrl = controllers::instance<XboxController, 1>();
+  ctrl.begin();
+  freeCtrl.begin();
+
+  const auto address = peripherals::address(1);
+  const auto freeAddress = peripherals::address(2);
+  host::addPeripheral(address, peripherals::xbox());
+  host::addPeripheral(freeAddress, peripherals::xbox());
+  const auto advertisement = peripherals::namedAdvertisement("Xbox Wireless Controller");
+  ASSERT_TRUE(controllers::connect(ctrl, address, advertisement));
+  host::waitIdle();
+
+  auto advertisements = syntheticAdvertisements(address);
+  // delivered first, the free controller would otherwise be allocated to one of the synthetic advertisements
+  advertisements.insert(advertisements.begin(), std::make_unique<NimBLEAdvertisedDevice>(freeAddress, advertisement));
+  auto* pCallbacks = NimBLEDevice::getScan()->getScanCallbacks();
+  ASSERT_NE(pCallbacks, nullptr);
+
+  // the connection is initiated from the scan callback, which runs on the host thread like on the NimBLE host task
+  size_t matchAllocations = 0;
+  size_t otherAllocations = 0;
+  host::post([&]() {
+    for (size_t i = 0; i < advertisements.size(); i++) {
+      allocationCount = 0;
+      countAllocations = true;
+      pCallbacks->onResult(advertisements[i].get());
+      countAllocations = false;
+      (i == 0 ? matchAllocations : otherAllocations) += allocationCount;
+    }
+  });
+  host::waitIdle();
+
+  EXPECT_GT(matchAllocations, 0u);
+  EXPECT_EQ(otherAllocations, 0u);
+  EXPECT_EQ(freeCtrl.getAddress(), freeAddress);
+  EXPECT_TRUE(host::waitFor([&]() { return freeCtrl.isConnected(); }));
+  host::waitIdle();
+
+  ASSERT_TRUE(controllers::disconnect(freeCtrl));
+  ASSERT_TRUE(controllers::disconnect(ctrl));
+}
@@ -0,0 +1,381 @@
+#include <gtest/gtest.h>
+#include <BLEGamepadClient.h>
+#include <BLEReportCapture.h>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+#include "controllers.h"
+#include "host.h"
+#include "peripherals.h"
+#include "reports.h"
+
+class MemoryStorage : public BLEStorage {
+ public:
+  size_t length(const char* key) override { return _values.count(key) ? _values[key].size() : 0; }
+
+  size_t read(const char* key, uint8_t buffer[], const size_t bufferLen) override {
+    const auto len = length(key);
+    if (len == 0 || len > bufferLen) {
+      return 0;
+    }
+    std::copy(_values[key].begin(), _values[key].end(), buffer);
+    return len;
+  }
+
+  bool write(const char* key, const uint8_t data[], const size_t dataLen) override {
+    _affinityWrites += key[0] == 'a';
+    _values[key].assign(data, data + dataLen);
+    return true;
+  }
+
+  bool remove(const char* key) override {
+    _values.erase(key);
+    return true;
+  }
+
+  /// @brief Number of cached attribute entries, their keys start with 'h'.
+  size_t attributeEntries() const {
+    size_t count = 0;
+    for (const auto& entry : _values) {
+      count += entry.first[0] == 'h';
+    }
+    return count;
+  }
+
+  /// @brief Number of writes of preferred addresses, their keys start with 'a'.
+  size_t affinityWrites() const { return _affinityWrites; }
+
+  /// @brief Keys of the preferred addresses.
+  std::vector<std::string> affinityKeys() const {
+    std::vector<std::string> keys;
+    for (const auto& entry : _values) {
+      if (entry.first[0] == 'a') {
+        keys.push_back(entry.first);
+      }
+    }
+    return keys;
+  }
+
+ private:
+  std::map<std::string, std::vector<uint8_t>> _values;
+  size_t _affinityWrites{0};
+};
+
+class ConnectionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    host::reset();
+    _ctrl.begin();
+  }
+
+  void TearDown() override { ASSERT_TRUE(controllers::disconnect(_ctrl)); }
+
+  XboxController& _ctrl = controllers::instance<XboxController>();
+};
+
+TEST_F(ConnectionTest, ConnectsAndReceivesReports) {
+  const auto address = peripherals::address(1);
+  host::addPeripheral(address, peripherals::xbox());
+
+  static std::atomic<uint32_t> changes{0};
+  _ctrl.onValueChanged([](XboxControlsState&, uint32_t, void*) { changes++; }, nullptr);
+
+  ASSERT_TRUE(controllers::connect(_ctrl, address, peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  EXPECT_EQ(address, _ctrl.getAddress());
+
+  auto* pChar = host::findCharacteristic(host::findClient(address), peripherals::xboxControlsHandle);
+  ASSERT_NE(nullptr, pChar);
+  ASSERT_TRUE(pChar->isSubscribed());
+
+  reports::Xbox report;
+  report.buttons[0] = 0x01;
+  const auto data = report.build();
+  host::post([&]() { pChar->notify(data.data(), data.size()); });
+  host::waitIdle();
+
+  ASSERT_TRUE(host::waitFor([&]() { return changes > 0; }));
+  XboxControlsState state;
+  _ctrl.read(&state);
+  EXPECT_TRUE(state.buttonA);
+
+  const auto timings = _ctrl.getConnectionTimings();
+  EXPECT_NE(0, timings.at(BLEConnectionStage::Allocated));
+  EXPECT_GE(timings.at(BLEConnectionStage::MarkedConnected), timings.at(BLEConnectionStage::Allocated));
+  EXPECT_LE(1u, _ctrl.getConnectionTimingStats().connections);
+}
+
+TEST_F(ConnectionTest, IgnoresDevicesOfOtherTypes) {
+  const auto address = peripherals::address(2);
+  host::addPeripheral(address, peripherals::steam());
+
+  NimBLEAdvertisedDevice adv(address, peripherals::namedAdvertisement("SteamController"));
+  ASSERT_TRUE(host::waitFor([&]() { return NimBLEDevice::getScan()->deliver(&adv); }));
+
+  EXPECT_FALSE(_ctrl.isConnecting());
+  EXPECT_EQ(0u, host::findPeripheral(address)->connects.load());
+}
+
+TEST_F(ConnectionTest, MatchesTheFirstManufacturerData) {
+  const auto address = peripherals::address(8);
+  host::addPeripheral(address, peripherals::xbox());
+
+  // an unnamed Xbox controller, matched by the gamepad appearance and the Microsoft company ID, followed by the
+  // manufacturer data of another company
+  // clang-format off
+  const std::vector<uint8_t> payload{
+      0x02, BLE_HS_ADV_TYPE_FLAGS, 0x06,
+      0x03, BLE_HS_ADV_TYPE_APPEARANCE, 0xc4, 0x03,
+      0x04, BLE_HS_ADV_TYPE_MFG_DATA, 0x06, 0x00, 0x01,
+      0x04, BLE_HS_ADV_TYPE_MFG_DATA, 0x4c, 0x00, 0x02,
+  };
+  // clang-format on
+  ASSERT_TRUE(controllers::connect(_ctrl, address, payload));
+}
+
+TEST_F(ConnectionTest, RefusesToReplayIntoAConnectedController) {
+  const auto address = peripherals::address(3);
+  host::addPeripheral(address, peripherals::xbox());
+
+  reports::Xbox report;
+  report.buttons[0] = 0x01;
+  auto capture = report.build();
+  const uint8_t header[BLEReportCapture::recordHeaderLen] = {0, 0, 0, 0, peripherals::xboxControlsHandle, 0,
+                                                             static_cast<uint8_t>(capture.size())};
+  capture.insert(capture.begin(), header, header + sizeof(header));
+
+  ASSERT_TRUE(controllers::connect(_ctrl, address, peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  EXPECT_EQ(0u, BLEReportCapture::replay<XboxControlsState>(_ctrl, capture.data(), capture.size(),
+                                                            BLEReportCapture::anyHandle, false));
+
+  ASSERT_TRUE(controllers::disconnect(_ctrl));
+  EXPECT_EQ(1u, BLEReportCapture::replay<XboxControlsState>(_ctrl, capture.data(), capture.size(),
+                                                            BLEReportCapture::anyHandle, false));
+  XboxControlsState state;
+  _ctrl.read(&state);
+  EXPECT_TRUE(state.buttonA);
+}
+
+TEST_F(ConnectionTest, CapturesNotificationsUntilStopped) {
+  const auto address = peripherals::address(15);
+  host::addPeripheral(address, peripherals::xbox());
+  ASSERT_TRUE(controllers::connect(_ctrl, address, peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  auto* pChar = host::findCharacteristic(host::findClient(address), peripherals::xboxControlsHandle);
+  ASSERT_NE(nullptr, pChar);
+
+  uint8_t buffer[256];
+  BLEReportCapture::start(buffer, sizeof(buffer));
+  reports::Xbox a;
+  a.buttons[0] = 0x01;
+  const auto data = a.build();
+  host::post([&]() { pChar->notify(data.data(), data.size()); });
+  host::waitIdle();
+
+  // the buffer is no longer written once stop() returns
+  BLEReportCapture::stop();
+  uint8_t records[sizeof(buffer)];
+  EXPECT_EQ(BLEReportCapture::recordHeaderLen + data.size(), BLEReportCapture::read(records, sizeof(records)));
+  std::fill(std::begin(buffer), std::end(buffer), 0xff);
+  reports::Xbox b;
+  b.buttons[0] = 0x02;
+  const auto ignored = b.build();
+  host::post([&]() { pChar->notify(ignored.data(), ignored.size()); });
+  host::waitIdle();
+
+  EXPECT_FALSE(BLEReportCapture::isActive());
+  EXPECT_TRUE(std::all_of(std::begin(buffer), std::end(buffer), [](const uint8_t byte) { return byte == 0xff; }));
+  ASSERT_TRUE(controllers::disconnect(_ctrl));
+}
+
+static std::vector<uint8_t> captureOf(const std::vector<std::vector<uint8_t>>& reports) {
+  std::vector<uint8_t> capture;
+  for (const auto& report : reports) {
+    const uint8_t header[BLEReportCapture::recordHeaderLen] = {0, 0, 0, 0, peripherals::xboxControlsHandle, 0,
+                                                               static_cast<uint8_t>(report.size())};
+    capture.insert(capture.end(), header, header + sizeof(header));
+    capture.insert(capture.end(), report.begin(), report.end());
+  }
+  return capture;
+}
+
+TEST_F(ConnectionTest, RecordsValueChangesInTheEventBuffer) {
+  const auto reset = captureOf({reports::Xbox().build()});
+  BLEReportCapture::replay<XboxControlsState>(_ctrl, reset.data(), reset.size(), BLEReportCapture::anyHandle, false);
+
+  BLEValueEvent<XboxControlsState> buffer[2];
+  _ctrl.setEventBuffer(buffer, std::size(buffer));
+
+  reports::Xbox a;
+  a.buttons[0] = 0x01;
+  reports::Xbox b;
+  b.buttons[0] = 0x02;
+  const auto capture = captureOf({a.build(), b.build(), a.build()});
+  ASSERT_EQ(3u, BLEReportCapture::replay<XboxControlsState>(_ctrl, capture.data(), capture.size(),
+                                                            BLEReportCapture::anyHandle, false));
+
+  BLEValueEvent<XboxControlsState> events[3];
+  uint32_t dropped = 0;
+  ASSERT_EQ(2u, _ctrl.drain(events, std::size(events), &dropped));
+  EXPECT_EQ(1u, dropped);
+  EXPECT_TRUE(events[0].value.buttonB);
+  EXPECT_TRUE(events[1].value.buttonA);
+  EXPECT_EQ(events[0].seq + 1, events[1].seq);
+
+  EXPECT_EQ(0u, _ctrl.drain(events, std::size(events), &dropped));
+  EXPECT_EQ(0u, dropped);
+  _ctrl.setEventBuffer(buffer, 0);
+}
+
+TEST_F(ConnectionTest, CachesOnlyCompleteAttributes) {
+  MemoryStorage storage;
+  BLEGamepadClient::setStorage(&storage);
+
+  // the report map characteristic reads empty
+  const auto emptyMapAddress = peripherals::address(4);
+  auto services = peripherals::xbox();
+  services[1].characteristics[0].value.clear();
+  host::addPeripheral(emptyMapAddress, services);
+
+  ASSERT_TRUE(controllers::connect(_ctrl, emptyMapAddress,
+                                   peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  EXPECT_EQ(0u, storage.attributeEntries());
+  ASSERT_TRUE(controllers::disconnect(_ctrl));
+
+  const auto address = peripherals::address(5);
+  host::addPeripheral(address, peripherals::xbox());
+  ASSERT_TRUE(controllers::connect(_ctrl, address, peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  EXPECT_EQ(1u, storage.attributeEntries());
+  ASSERT_TRUE(controllers::disconnect(_ctrl));
+
+  BLEGamepadClient::setStorage(nullptr);
+}
+
+TEST_F(ConnectionTest, SwitchesAdaptiveModeOnceTheControllerAccepts) {
+  _ctrl.setConnectionProfile(BLEConnectionProfile::Adaptive);
+  const auto goIdle = [&](const std::shared_ptr<host::Peripheral>& pPeripheral) {
+    const auto requests = pPeripheral->connParamsRequests.load();
+    host::useManualClock(esp_timer_get_time());
+    host::advanceTimeUs(CONFIG_BT_BLEGC_ADAPTIVE_IDLE_TIMEOUT_MS * 1000ll + 1);
+    const auto requested = host::waitFor([&]() { return pPeripheral->connParamsRequests > requests; });
+    host::waitIdle();
+    host::useRealClock();
+    return requested;
+  };
+
+  const auto rejectingAddress = peripherals::address(6);
+  host::addPeripheral(rejectingAddress, peripherals::xbox());
+  auto pRejecting = host::findPeripheral(rejectingAddress);
+  ASSERT_TRUE(controllers::connect(_ctrl, rejectingAddress,
+                                   peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  host::waitIdle();
+  pRejecting->acceptsConnParams = false;
+  ASSERT_TRUE(goIdle(pRejecting));
+  EXPECT_EQ(0u, _ctrl.getAdaptiveConnectionStats().switches);
+  EXPECT_EQ(7500u, _ctrl.getConnectionParams().intervalUs);
+  ASSERT_TRUE(controllers::disconnect(_ctrl));
+
+  const auto address = peripherals::address(7);
+  host::addPeripheral(address, peripherals::xbox());
+  auto pPeripheral = host::findPeripheral(address);
+  ASSERT_TRUE(controllers::connect(_ctrl, address, peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  host::waitIdle();
+  ASSERT_TRUE(goIdle(pPeripheral));
+  EXPECT_TRUE(host::waitFor([&]() { return _ctrl.getAdaptiveConnectionStats().switches == 1; }));
+  EXPECT_EQ(100000u, _ctrl.getConnectionParams().intervalUs);
+
+  _ctrl.setConnectionProfile(BLEConnectionProfile::Default);
+}
+
+TEST_F(ConnectionTest, FallsBackToAnOpenScanWhenTheAcceptListTimesOut) {
+  auto* pScan = NimBLEDevice::getScan();
+  const auto address = peripherals::address(9);
+  host::addPeripheral(address, peripherals::xbox());
+  ASSERT_TRUE(controllers::connect(_ctrl, address, peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  host::waitIdle();
+
+  // the controller comes back with an address that is neither its last one nor bonded
+  const auto newAddress = peripherals::address(10);
+  host::addPeripheral(newAddress, peripherals::xbox());
+  NimBLEAdvertisedDevice adv(newAddress, peripherals::namedAdvertisement("Xbox Wireless Controller"));
+
+  BLEGamepadClient::getAutoScan()->setAcceptListScan(true);
+  host::useManualClock(esp_timer_get_time());
+  auto starts = pScan->getStartCount();
+  ASSERT_TRUE(controllers::disconnect(_ctrl));
+  ASSERT_TRUE(host::waitFor([&]() { return pScan->getStartCount() != starts; }));
+  EXPECT_EQ(BLE_HCI_SCAN_FILT_USE_WL, pScan->getFilterPolicy());
+  EXPECT_EQ(CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_TIMEOUT_MS, pScan->getDuration());
+  EXPECT_FALSE(pScan->deliver(&adv));
+
+  host::advanceTimeUs(CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_TIMEOUT_MS * 1000ll);
+  starts = pScan->getStartCount();
+  pScan->end(0);
+  ASSERT_TRUE(host::waitFor([&]() { return pScan->getStartCount() != starts; }));
+  EXPECT_EQ(BLE_HCI_SCAN_FILT_NO_WL, pScan->getFilterPolicy());
+  EXPECT_TRUE(controllers::connect(_ctrl, newAddress, peripherals::namedAdvertisement("Xbox Wireless Controller")));
+
+  host::useRealClock();
+  BLEGamepadClient::getAutoScan()->setAcceptListScan(CONFIG_BT_BLEGC_ACCEPT_LIST_SCAN_ENABLED > 0);
+}
+
+TEST_F(ConnectionTest, StoresThePreferredAddressWhenItChanges) {
+  MemoryStorage storage;
+  BLEGamepadClient::setStorage(&storage);
+
+  const auto address = peripherals::address(11);
+  host::addPeripheral(address, peripherals::xbox());
+  ASSERT_TRUE(controllers::connect(_ctrl, address, peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  EXPECT_EQ(1u, storage.affinityWrites());
+  ASSERT_TRUE(controllers::disconnect(_ctrl));
+
+  ASSERT_TRUE(controllers::connect(_ctrl, address, peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  EXPECT_EQ(1u, storage.affinityWrites());
+  ASSERT_TRUE(controllers::disconnect(_ctrl));
+
+  const auto otherAddress = peripherals::address(12);
+  host::addPeripheral(otherAddress, peripherals::xbox());
+  ASSERT_TRUE(controllers::connect(_ctrl, otherAddress,
+                                   peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  EXPECT_EQ(2u, storage.affinityWrites());
+
+  // keyed by the controller type and the instance of the type, not by the registration slot
+  const auto keys = storage.affinityKeys();
+  ASSERT_EQ(1u, keys.size());
+  EXPECT_EQ(10u, keys[0].size());
+  EXPECT_EQ('0', keys[0].back());
+  ASSERT_TRUE(controllers::disconnect(_ctrl));
+
+  BLEGamepadClient::setStorage(nullptr);
+}
+
+TEST_F(ConnectionTest, StoresThePreferredAddressAfterAFailedConnection) {
+  MemoryStorage storage;
+  BLEGamepadClient::setStorage(&storage);
+
+  const auto address = peripherals::address(13);
+  host::addPeripheral(address, peripherals::xbox());
+  ASSERT_TRUE(controllers::connect(_ctrl, address, peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  EXPECT_EQ(1u, storage.affinityWrites());
+  ASSERT_TRUE(controllers::disconnect(_ctrl));
+
+  // a failed connection sets the last address, but the storage still holds the previous one
+  const auto otherAddress = peripherals::address(14);
+  host::addPeripheral(otherAddress, peripherals::xbox());
+  host::findPeripheral(otherAddress)->acceptsConnection = false;
+  NimBLEAdvertisedDevice adv(otherAddress, peripherals::namedAdvertisement("Xbox Wireless Controller"));
+  ASSERT_TRUE(host::waitFor([&]() {
+    NimBLEDevice::getScan()->deliver(&adv);
+    return _ctrl.getLastAddress() == otherAddress && _ctrl.getAddress().isNull();
+  }));
+  host::waitIdle();
+
+  host::findPeripheral(otherAddress)->acceptsConnection = true;
+  ASSERT_TRUE(controllers::connect(_ctrl, otherAddress,
+                                   peripherals::namedAdvertisement("Xbox Wireless Controller")));
+  EXPECT_EQ(2u, storage.affinityWrites());
+  ASSERT_TRUE(controllers::disconnect(_ctrl));
+
+  BLEGamepadClient::setStorage(nullptr);
+}
@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include "hid/HIDDecodePlan.h"
+#include "hid/HIDGamepadState.h"
+#include "reports.h"
+#include "steam/SteamControlsState.h"
+#include "xbox/XboxBatteryState.h"
+#include "xbox/XboxControlsState.h"
+
+TEST(XboxControlsStateTest, DecodesSticksTriggersAndButtons) {
+  reports::Xbox report;
+  report.leftStickX = 0xffff;
+  report.rightStickY = 0;
+  report.leftTrigger = 0x3ff;
+  report.dpad = 3;
+  report.buttons[0] = 0x01;
+  auto data = report.build();
+
+  XboxControlsState state;
+  uint32_t changedFields;
+  ASSERT_EQ(BLEDecodeResult::Success, state.decode(data.data(), data.size(), changedFields));
+
+  EXPECT_EQ(XboxControlsState::LeftStickX | XboxControlsState::RightStickY | XboxControlsState::LeftTrigger |
+                XboxControlsState::DpadRight | XboxControlsState::ButtonA,
+            changedFields);
+  EXPECT_FLOAT_EQ(1.0f, state.leftStickX);
+  EXPECT_FLOAT_EQ(1.0f, state.rightStickY);
+  EXPECT_FLOAT_EQ(1.0f, state.leftTrigger);
+  EXPECT_TRUE(state.dpadRight);
+  EXPECT_TRUE(state.buttonA);
+  EXPECT_FALSE(state.buttonB);
+}
+
+TEST(XboxControlsStateTest, ReportsNoChangesForTheSameReport) {
+  auto data = reports::Xbox().build();
+  XboxControlsState state;
+  uint32_t changedFields;
+  ASSERT_EQ(BLEDecodeResult::Success, state.decode(data.data(), data.size(), changedFields));
+  EXPECT_EQ(0u, changedFields);
+}
+
+TEST(XboxControlsStateTest, RejectsReportsOfOtherLengths) {
+  auto data = reports::Xbox().build();
+  data.pop_back();
+  XboxControlsState state;
+  uint32_t changedFields;
+  EXPECT_EQ(BLEDecodeResult::InvalidReport, state.decode(data.data(), data.size(), changedFields));
+}
+
+TEST(XboxBatteryStateTest, DecodesLevel) {
+  auto data = reports::xboxBattery(50);
+  XboxBatteryState state;
+  uint32_t changedFields;
+  ASSERT_EQ(BLEDecodeResult::Success, state.decode(data.data(), data.size(), changedFields));
+  EXPECT_EQ(XboxBatteryState::Level, changedFields);
+  EXPECT_FLOAT_EQ(0.5f, state.level);
+}
+
+TEST(SteamControlsStateTest, DecodesAnnouncedSections) {
+  reports::Steam report;
+  report.contentInfo = reports::steamButtons | reports::steamTriggers | reports::steamStick;
+  report.buttons[0] = 0x80;
+  report.rightTrigger = 0xff;
+  report.stickX = INT16_MAX;
+  auto data = report.build();
+
+  SteamControlsState state;
+  uint32_t changedFields;
+  ASSERT_EQ(BLEDecodeResult::Success, state.decode(data.data(), data.size(), changedFields));
+
+  EXPECT_EQ(SteamControlsState::ButtonA | SteamControlsState::RightTrigger | SteamControlsState::StickX,
+            changedFields);
+  EXPECT_TRUE(state.buttonA);
+  EXPECT_FLOAT_EQ(1.0f, state.rightTrigger);
+  EXPECT_FLOAT_EQ(1.0f, state.stickX);
+}
+
+TEST(SteamControlsStateTest, KeepsSectionsThatAreNotAnnounced) {
+  reports::Steam report;
+  report.contentInfo = reports::steamTriggers;
+  report.leftTrigger = 0x80;
+  auto data = report.build();
+
+  SteamControlsState state;
+  state.raw.buttons = SteamControlsState::ButtonB;
+  uint32_t changedFields;
+  ASSERT_EQ(BLEDecodeResult::Success, state.decode(data.data(), data.size(), changedFields));
+
+  EXPECT_EQ(SteamControlsState::LeftTrigger, changedFields);
+  EXPECT_TRUE(state.buttonB);
+}
+
+TEST(SteamControlsStateTest, RefusesSectionsThatExceedTheReport) {
+  reports::Steam report;
+  report.contentInfo = reports::steamButtons | reports::steamTriggers | reports::steamStick | reports::steamLeftPad |
+                       reports::steamRightPad;
+  report.leftTrigger = 0x80;
+  report.leftPadX = 1000;
+  report.rightPadX = 1000;
+  auto data = report.build();
+  ASSERT_EQ(19u, data.size());
+
+  SteamControlsState state;
+  uint32_t changedFields;
+  // the right pad section is one byte longer than what is left of the report
+  ASSERT_EQ(BLEDecodeResult::NotSupported, state.decode(data.data(), data.size(), changedFields));
+
+  EXPECT_EQ(0u, changedFields);
+  EXPECT_EQ(0, state.raw.leftPadX);
+  EXPECT_EQ(0, state.raw.rightPadX);
+}
+
+TEST(SteamControlsStateTest, IgnoresOtherReports) {
+  auto data = reports::Steam().build();
+  data[0] = 0x01;
+  SteamControlsState state;
+  uint32_t changedFields;
+  EXPECT_EQ(BLEDecodeResult::NotSupported, state.decode(data.data(), data.size(), changedFields));
+}
+
+TEST(XboxControlsStateTest, ClampsTriggersAboveTheMaximum) {
+  XboxControlsState state;
+  state.raw.leftTrigger = XboxControlsState::triggerMax;
+  state.raw.rightTrigger = 0xffff;
+  EXPECT_EQ(XboxControlsState::q15Max, state.leftTriggerQ15());
+  EXPECT_EQ(XboxControlsState::q15Max, state.rightTriggerQ15());
+
+  state.raw.rightTrigger = XboxControlsState::triggerMax + 1;
+  EXPECT_EQ(XboxControlsState::q15Max, state.rightTriggerQ15());
+}
+
+TEST(SteamControlsStateTest, ClampsTriggersAboveTheMaximum) {
+  SteamControlsState state;
+  state.raw.leftTrigger = SteamControlsState::triggerMax;
+  state.raw.rightTrigger = 0xffff;
+  EXPECT_EQ(SteamControlsState::q15Max, state.leftTriggerQ15());
+  EXPECT_EQ(SteamControlsState::q15Max, state.rightTriggerQ15());
+}
+
+TEST(HIDDecodePlanTest, LeavesFieldsPastTheUsageRangeUndecoded) {
+  const uint8_t reportMap[] = {
+      0x05, 0x09,  // usage page (button)
+      0x19, 0x01,  // usage minimum (1)
+      0x29, 0x04,  // usage maximum (4)
+      0x15, 0x00,  // logical minimum (0)
+      0x25, 0x01,  // logical maximum (1)
+      0x75, 0x01,  // report size (1)
+      0x95, 0x08,  // report count (8)
+      0x81, 0x02,  // input (data, variable, absolute)
+  };
+  HIDDecodePlan plan;
+  ASSERT_TRUE(plan.parse(reportMap, sizeof(reportMap)));
+  ASSERT_EQ(1u, plan.stepCount());
+  EXPECT_EQ(4, plan.steps()[0].bitSize);
+
+  HIDGamepadState state;
+  state.plan = &plan;
+  uint8_t report[] = {0xff};
+  uint32_t changedFields;
+  ASSERT_EQ(BLEDecodeResult::Success, state.decode(report, sizeof(report), changedFields));
+  EXPECT_EQ(0x0fu, state.raw.buttons);
+}
+
+TEST(HIDDecodePlanTest, RestoresPushedGlobalItems) {
+  const uint8_t reportMap[] = {
+      0x05, 0x01,        // usage page (generic desktop)
+      0x09, 0x30,        // usage (x)
+      0x15, 0x00,        // logical minimum (0)
+      0x26, 0xff, 0x00,  // logical maximum (255)
+      0x75, 0x08,        // report size (8)
+      0x95, 0x01,        // report count (1)
+      0x81, 0x02,        // input (data, variable, absolute)
+      0xa4,              // push
+      0x05, 0x09,        // usage page (button)
+      0x19, 0x01,        // usage minimum (1)
+      0x29, 0x08,        // usage maximum (8)
+      0x25, 0x01,        // logical maximum (1)
+      0x75, 0x01,        // report size (1)
+      0x95, 0x08,        // report count (8)
+      0x81, 0x02,        // input (data, variable, absolute)
+      0xb4,              // pop
+      0x09, 0x31,        // usage (y)
+      0x81, 0x02,        // input (data, variable, absolute)
+  };
+  HIDDecodePlan plan;
+  ASSERT_TRUE(plan.parse(reportMap, sizeof(reportMap)));
+  ASSERT_EQ(3u, plan.stepCount());
+  EXPECT_EQ(HIDDecodePlan::Target::Axis, plan.steps()[2].target);
+  EXPECT_EQ(HIDGamepadState::Y, plan.steps()[2].index);
+  EXPECT_EQ(16, plan.steps()[2].bitOffset);
+  EXPECT_EQ(8, plan.steps()[2].bitSize);
+  EXPECT_EQ(255, plan.steps()[2].logicalMax);
+
+  HIDGamepadState state;
+  state.plan = &plan;
+  uint8_t report[] = {0x80, 0x01, 0xff};
+  uint32_t changedFields;
+  ASSERT_EQ(BLEDecodeResult::Success, state.decode(report, sizeof(report), changedFields));
+  EXPECT_EQ(1u | HIDGamepadState::AxisX | HIDGamepadState::AxisY, changedFields);
+  EXPECT_EQ(HIDGamepadState::q15Max, state.raw.axes[HIDGamepadState::Y]);
+}
+
+TEST(HIDDecodePlanTest, RejectsUnbalancedPop) {
+  const uint8_t reportMap[] = {0x05, 0x01, 0xb4, 0x09, 0x30, 0x75, 0x08, 0x95, 0x01, 0x81, 0x02};
+  HIDDecodePlan plan;
+  EXPECT_FALSE(plan.parse(reportMap, sizeof(reportMap)));
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <BLEValueSnapshot.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "xbox/XboxControlsState.h"
+
+namespace {
+
+// large enough that a write is likely to be interrupted halfway, every word holds the same sequence number
+struct Payload {
+  uint32_t words[64];
+};
+
+// the writer keeps going until the readers have overlapped with it enough, also on a single core
+constexpr uint32_t minWrites = 200000;
+constexpr uint32_t minReads = 100000;
+constexpr size_t readers = 3;
+
+}  // namespace
+
+TEST(BLEValueSnapshotTest, ReadersNeverObserveTornWrites) {
+  BLEValueSnapshot<Payload> snapshot;
+  std::atomic_bool done{false};
+  std::atomic<uint32_t> tornReads{0};
+  std::atomic<uint32_t> reads{0};
+
+  std::vector<std::thread> readerThreads;
+  for (size_t r = 0; r < readers; r++) {
+    readerThreads.emplace_back([&]() {
+      uint32_t last = 0;
+      Payload payload;
+      while (!done) {
+        snapshot.read(&payload);
+        reads++;
+        for (const auto word : payload.words) {
+          if (word != payload.words[0]) {
+            tornReads++;
+            break;
+          }
+        }
+        // values are published in order, a reader never goes back in time
+        EXPECT_GE(payload.words[0], last);
+        last = payload.words[0];
+      }
+    });
+  }
+
+  uint32_t seq = 0;
+  while (++seq <= minWrites || reads < minReads) {
+    auto& payload = snapshot.beginWrite();
+    for (auto& word : payload.words) {
+      word = seq;
+    }
+    snapshot.endWrite();
+  }
+  done = true;
+  for (auto& thread : readerThreads) {
+    thread.join();
+  }
+
+  Payload last;
+  snapshot.read(&last);
+  EXPECT_EQ(seq - 1, last.words[0]);
+  EXPECT_EQ(0u, tornReads.load());
+}
+
+TEST(BLEValueSnapshotTest, ReadersNeverObserveTornControls) {
+  BLEValueSnapshot<XboxControlsState> snapshot;
+  std::atomic_bool done{false};
+  std::atomic<uint32_t> tornReads{0};
+  std::atomic<uint32_t> reads{0};
+
+  std::thread reader([&]() {
+    XboxControlsState state;
+    while (!done) {
+      snapshot.read(&state);
+      reads++;
+      const auto& raw = state.raw;
+      if (raw.leftStickX != raw.leftStickY || raw.leftStickX != raw.rightStickX ||
+          raw.leftStickX != raw.rightStickY || raw.buttons != raw.leftStickX) {
+        tornReads++;
+      }
+    }
+  });
+
+  for (uint32_t i = 1; i <= minWrites || reads < minReads; i++) {
+    const auto val = static_cast<uint16_t>(i);
+    auto& state = snapshot.beginWrite();
+    state.raw = {val, val, val, val, val, 0, 0};
+    snapshot.endWrite();
+  }
+  done = true;
+  reader.join();
+
+  EXPECT_EQ(0u, tornReads.load());
+}